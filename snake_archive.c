@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "snake_archive.h"
+
+int host_little_endian();
+int grow_columns(ArchiveWriter *w);
+int write_bytes(ArchiveWriter *w, const void *data, size_t size);
+int flush_buffer(ArchiveWriter *w);
+void put_header(unsigned char *out, uint32_t count, uint64_t index_offset);
+uint64_t read_le(const unsigned char *in, int bytes);
+const unsigned char *map_file(const char *path, size_t *size);
+void unmap_file(const unsigned char *base, size_t size);
+
+int host_little_endian() {
+    uint16_t probe = 1;
+    return *(unsigned char *)&probe == 1;
+}
+
+int create_archive(ArchiveWriter *w, const char *path) {
+    memset(w, 0, sizeof(*w));
+    if (!host_little_endian()) return 0;
+    
+    w->buffer = malloc(ARCHIVE_BUFFER_SIZE);
+    w->file = fopen(path, "wb");
+    if (!w->buffer || !w->file) {
+        if (w->file) fclose(w->file);
+        free(w->buffer);
+        memset(w, 0, sizeof(*w));
+        return 0;
+    }
+    
+    setvbuf(w->file, NULL, _IONBF, 0);
+    memset(w->buffer, 0, ARCHIVE_HEADER_SIZE);
+    w->buffered = ARCHIVE_HEADER_SIZE;
+    w->offset = ARCHIVE_HEADER_SIZE;
+    return 1;
+}
+
+int grow_columns(ArchiveWriter *w) {
+    uint32_t capacity = w->capacity > 0 ? w->capacity * 2 : 1024;
+    
+    uint64_t *seeds = realloc(w->seeds, sizeof(uint64_t) * capacity);
+    if (seeds) w->seeds = seeds;
+    uint64_t *offsets = realloc(w->offsets, sizeof(uint64_t) * capacity);
+    if (offsets) w->offsets = offsets;
+    uint32_t *sizes = realloc(w->sizes, sizeof(uint32_t) * capacity);
+    if (sizes) w->sizes = sizes;
+    uint32_t *ticks = realloc(w->ticks, sizeof(uint32_t) * capacity);
+    if (ticks) w->ticks = ticks;
+    uint32_t *lengths = realloc(w->lengths, sizeof(uint32_t) * capacity);
+    if (lengths) w->lengths = lengths;
+    int32_t *scores = realloc(w->scores, sizeof(int32_t) * capacity);
+    if (scores) w->scores = scores;
+    
+    if (!seeds || !offsets || !sizes || !ticks || !lengths || !scores) return 0;
+    w->capacity = capacity;
+    return 1;
+}
+
+int append_replay(ArchiveWriter *w, ReplayWriter *r, const GameState *g) {
+    if (w->count == w->capacity && !grow_columns(w)) return 0;
+    if (r->size > UINT32_MAX) return 0;
+    
+    seal_recording(r);
+    
+    uint32_t i = w->count;
+    w->seeds[i] = r->header.seed;
+    w->offsets[i] = w->offset;
+    w->sizes[i] = (uint32_t)r->size;
+    w->ticks[i] = r->header.ticks;
+    w->lengths[i] = (uint32_t)g->snake_length;
+    w->scores[i] = g->score;
+    
+    if (!write_bytes(w, r->data, r->size)) return 0;
+    w->count++;
+    return 1;
+}
+
+int write_bytes(ArchiveWriter *w, const void *data, size_t size) {
+    if (w->buffered + size > ARCHIVE_BUFFER_SIZE && !flush_buffer(w)) return 0;
+    
+    if (size >= ARCHIVE_BUFFER_SIZE) {
+        if (fwrite(data, 1, size, w->file) != size) return 0;
+    }
+    else {
+        memcpy(w->buffer + w->buffered, data, size);
+        w->buffered += size;
+    }
+    
+    w->offset += size;
+    return 1;
+}
+
+int flush_buffer(ArchiveWriter *w) {
+    size_t size = w->buffered;
+    
+    w->buffered = 0;
+    return size == 0 || fwrite(w->buffer, 1, size, w->file) == size;
+}
+
+void put_header(unsigned char *out, uint32_t count, uint64_t index_offset) {
+    uint64_t fields[4] = {ARCHIVE_MAGIC | (uint64_t)ARCHIVE_VERSION << 32, count, index_offset, 0};
+    
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 8; b++) {
+            out[i * 8 + b] = (unsigned char)(fields[i] >> (8 * b));
+        }
+    }
+}
+
+int finish_archive(ArchiveWriter *w) {
+    static const unsigned char padding[8] = {0};
+    size_t n = w->count;
+    
+    int ok = write_bytes(w, padding, (size_t)(-w->offset & 7));
+    uint64_t index_offset = w->offset;
+    ok = ok && write_bytes(w, w->seeds, sizeof(uint64_t) * n);
+    ok = ok && write_bytes(w, w->offsets, sizeof(uint64_t) * n);
+    ok = ok && write_bytes(w, w->sizes, sizeof(uint32_t) * n);
+    ok = ok && write_bytes(w, w->ticks, sizeof(uint32_t) * n);
+    ok = ok && write_bytes(w, w->lengths, sizeof(uint32_t) * n);
+    ok = ok && write_bytes(w, w->scores, sizeof(int32_t) * n);
+    ok = ok && flush_buffer(w);
+    
+    unsigned char header[ARCHIVE_HEADER_SIZE];
+    put_header(header, w->count, index_offset);
+    ok = ok && fseek(w->file, 0, SEEK_SET) == 0;
+    ok = ok && fwrite(header, 1, ARCHIVE_HEADER_SIZE, w->file) == ARCHIVE_HEADER_SIZE;
+    ok = fclose(w->file) == 0 && ok;
+    
+    free(w->buffer);
+    free(w->seeds);
+    free(w->offsets);
+    free(w->sizes);
+    free(w->ticks);
+    free(w->lengths);
+    free(w->scores);
+    memset(w, 0, sizeof(*w));
+    return ok;
+}
+
+uint64_t read_le(const unsigned char *in, int bytes) {
+    uint64_t value = 0;
+    
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+const unsigned char *map_file(const char *path, size_t *size) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file == INVALID_HANDLE_VALUE) return NULL;
+    
+    LARGE_INTEGER length;
+    const unsigned char *base = NULL;
+    if (GetFileSizeEx(file, &length) && length.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping) {
+            base = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        *size = (size_t)length.QuadPart;
+    }
+    
+    CloseHandle(file);
+    return base;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    
+    struct stat st;
+    const unsigned char *base = NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            base = p;
+            *size = (size_t)st.st_size;
+        }
+    }
+    
+    close(fd);
+    return base;
+#endif
+}
+
+void unmap_file(const unsigned char *base, size_t size) {
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(base);
+#else
+    munmap((void *)base, size);
+#endif
+}
+
+int open_archive(ReplayArchive *a, const char *path) {
+    memset(a, 0, sizeof(*a));
+    if (!host_little_endian()) return 0;
+    
+    a->base = map_file(path, &a->size);
+    if (!a->base) return 0;
+    if (a->size < ARCHIVE_HEADER_SIZE) {
+        close_archive(a);
+        return 0;
+    }
+    
+    uint64_t tag = read_le(a->base, 8);
+    uint64_t count = read_le(a->base + 8, 8);
+    uint64_t index_offset = read_le(a->base + 16, 8);
+    int ok = tag == (ARCHIVE_MAGIC | (uint64_t)ARCHIVE_VERSION << 32) &&
+             count <= UINT32_MAX && index_offset % 8 == 0 &&
+             index_offset <= a->size && (a->size - index_offset) / 32 >= count;
+    
+    if (!ok) {
+        close_archive(a);
+        return 0;
+    }
+    
+    const unsigned char *column = a->base + index_offset;
+    a->count = (uint32_t)count;
+    a->seeds = (const uint64_t *)column;
+    a->offsets = a->seeds + count;
+    a->sizes = (const uint32_t *)(a->offsets + count);
+    a->ticks = a->sizes + count;
+    a->lengths = a->ticks + count;
+    a->scores = (const int32_t *)(a->lengths + count);
+    return 1;
+}
+
+void close_archive(ReplayArchive *a) {
+    if (a->base) {
+        unmap_file(a->base, a->size);
+    }
+    memset(a, 0, sizeof(*a));
+}
+
+int open_archived_replay(const ReplayArchive *a, uint32_t index, ReplayPlayer *p) {
+    if (index >= a->count) return 0;
+    
+    uint64_t offset = a->offsets[index];
+    uint32_t size = a->sizes[index];
+    if (offset < ARCHIVE_HEADER_SIZE || offset > a->size || size > a->size - offset) return 0;
+    
+    return open_replay(p, a->base + offset, size);
+}
\ No newline at end of file
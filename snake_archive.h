@@ -0,0 +1,50 @@
+#ifndef SNAKE_ARCHIVE_H
+#define SNAKE_ARCHIVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "snake_core.h"
+#include "snake_replay.h"
+
+#define ARCHIVE_MAGIC 0x414B4E53u
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_HEADER_SIZE 32
+#define ARCHIVE_BUFFER_SIZE (1 << 20)
+
+typedef struct {
+    FILE *file;
+    unsigned char *buffer;
+    size_t buffered;
+    uint64_t offset;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t *seeds;
+    uint64_t *offsets;
+    uint32_t *sizes;
+    uint32_t *ticks;
+    uint32_t *lengths;
+    int32_t *scores;
+} ArchiveWriter;
+
+typedef struct {
+    const unsigned char *base;
+    size_t size;
+    uint32_t count;
+    const uint64_t *seeds;
+    const uint64_t *offsets;
+    const uint32_t *sizes;
+    const uint32_t *ticks;
+    const uint32_t *lengths;
+    const int32_t *scores;
+} ReplayArchive;
+
+int create_archive(ArchiveWriter *w, const char *path);
+int append_replay(ArchiveWriter *w, ReplayWriter *r, const GameState *g);
+int finish_archive(ArchiveWriter *w);
+int open_archive(ReplayArchive *a, const char *path);
+void close_archive(ReplayArchive *a);
+int open_archived_replay(const ReplayArchive *a, uint32_t index, ReplayPlayer *p);
+
+#endif
@@ -0,0 +1,398 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_arena.h"
+
+void add_free(Arena *a, Cell c);
+void take_free(Arena *a, Cell c);
+void add_food(Arena *a, Cell c);
+void take_food(Arena *a, Cell c);
+int grow_snake(ArenaSnake *s);
+void pop_tail(Arena *a, ArenaSnake *s);
+void kill_snake(Arena *a, ArenaSnake *s);
+int spawn_snake(Arena *a, int i);
+void top_up_food(Arena *a);
+int leaves_tail(const ArenaSnake *s);
+int blocked(Arena *a, Cell c);
+int arena_distance(const Board *b, Cell from, Cell to);
+Direction steer_toward(Arena *a, ArenaSnake *s);
+
+int alloc_arena(Arena *a, const Board *b, int snakes, int food) {
+    memset(a, 0, sizeof(*a));
+    if (snakes < 1 || snakes > ARENA_MAX_SNAKES || snakes + food > b->cells) {
+        return 0;
+    }
+    
+    a->board = b;
+    a->food_target = food;
+    a->occupant = calloc((size_t)b->cells, sizeof(int32_t));
+    a->claim = calloc((size_t)b->cells, sizeof(uint32_t));
+    a->slot = malloc(sizeof(int32_t) * (size_t)b->cells);
+    a->free_cells = malloc(sizeof(Cell) * (size_t)b->cells);
+    a->food = malloc(sizeof(Cell) * (size_t)(food > 0 ? food : 1));
+    a->snakes = calloc((size_t)snakes, sizeof(ArenaSnake));
+    if (!a->occupant || !a->claim || !a->slot || !a->free_cells || !a->food || !a->snakes) {
+        free_arena(a);
+        return 0;
+    }
+    
+    for (Cell c = 0; c < (Cell)b->cells; c++) {
+        add_free(a, c);
+    }
+    
+    a->snake_count = snakes;
+    for (int i = 0; i < snakes; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        s->body = malloc(sizeof(Cell) * INITIAL_CAPACITY);
+        if (!s->body) {
+            free_arena(a);
+            return 0;
+        }
+        s->mask = INITIAL_CAPACITY - 1;
+    }
+    
+    return 1;
+}
+
+int create_arena(Arena *a, const Board *b, int snakes, int food, uint64_t seed) {
+    if (!alloc_arena(a, b, snakes, food)) return 0;
+    
+    rng_seed(&a->rng, seed);
+    for (int i = 0; i < snakes; i++) {
+        spawn_snake(a, i);
+    }
+    
+    top_up_food(a);
+    return 1;
+}
+
+void free_arena(Arena *a) {
+    for (int i = 0; a->snakes && i < a->snake_count; i++) {
+        free(a->snakes[i].body);
+    }
+    free(a->snakes);
+    free(a->occupant);
+    free(a->claim);
+    free(a->slot);
+    free(a->free_cells);
+    free(a->food);
+    memset(a, 0, sizeof(*a));
+}
+
+void clear_arena(Arena *a) {
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        while (s->length > 0) {
+            pop_tail(a, s);
+        }
+        s->alive = 0;
+    }
+    
+    while (a->food_count > 0) {
+        Cell c = a->food[a->food_count - 1];
+        take_food(a, c);
+        add_free(a, c);
+    }
+    a->alive = 0;
+}
+
+void add_free(Arena *a, Cell c) {
+    a->slot[c] = a->free_count;
+    a->free_cells[a->free_count++] = c;
+}
+
+void take_free(Arena *a, Cell c) {
+    Cell last = a->free_cells[--a->free_count];
+    
+    a->free_cells[a->slot[c]] = last;
+    a->slot[last] = a->slot[c];
+}
+
+void add_food(Arena *a, Cell c) {
+    take_free(a, c);
+    a->occupant[c] = ARENA_FOOD;
+    a->slot[c] = a->food_count;
+    a->food[a->food_count++] = c;
+}
+
+void take_food(Arena *a, Cell c) {
+    Cell last = a->food[--a->food_count];
+    
+    a->food[a->slot[c]] = last;
+    a->slot[last] = a->slot[c];
+    a->occupant[c] = ARENA_EMPTY;
+}
+
+int grow_snake(ArenaSnake *s) {
+    int capacity = s->mask + 1;
+    Cell *body = malloc(sizeof(Cell) * (size_t)capacity * 2);
+    if (!body) return 0;
+    
+    int first = capacity - s->tail;
+    memcpy(body, &s->body[s->tail], sizeof(Cell) * (size_t)first);
+    memcpy(&body[first], s->body, sizeof(Cell) * (size_t)s->tail);
+    
+    free(s->body);
+    s->body = body;
+    s->mask = capacity * 2 - 1;
+    s->tail = 0;
+    s->head = s->length - 1;
+    return 1;
+}
+
+int push_head(Arena *a, int i, Cell c) {
+    ArenaSnake *s = &a->snakes[i];
+    
+    if (s->length > s->mask && !grow_snake(s)) {
+        return 0;
+    }
+    
+    if (a->occupant[c] == ARENA_FOOD) {
+        take_food(a, c);
+        s->score += 10;
+        s->grow++;
+    }
+    else {
+        take_free(a, c);
+    }
+    
+    a->occupant[c] = i + 1;
+    s->head = (s->head + 1) & s->mask;
+    s->body[s->head] = c;
+    s->length++;
+    if (s->length > s->best_length) {
+        s->best_length = s->length;
+    }
+    return 1;
+}
+
+void pop_tail(Arena *a, ArenaSnake *s) {
+    Cell c = s->body[s->tail];
+    
+    a->occupant[c] = ARENA_EMPTY;
+    add_free(a, c);
+    s->tail = (s->tail + 1) & s->mask;
+    s->length--;
+}
+
+void kill_snake(Arena *a, ArenaSnake *s) {
+    while (s->length > 0) {
+        pop_tail(a, s);
+    }
+    
+    s->alive = 0;
+    a->alive--;
+    a->deaths++;
+}
+
+int spawn_snake(Arena *a, int i) {
+    if (a->free_count == 0) return 0;
+    
+    Cell c = a->free_cells[rng_bounded(&a->rng, (uint32_t)a->free_count)];
+    return place_snake(a, i, c, (Direction)rng_bounded(&a->rng, 4));
+}
+
+int place_snake(Arena *a, int i, Cell c, Direction dir) {
+    ArenaSnake *s = &a->snakes[i];
+    
+    if (s->alive || a->occupant[c] != ARENA_EMPTY) return 0;
+    
+    s->head = s->mask;
+    s->tail = 0;
+    s->length = 0;
+    s->grow = START_LENGTH - 1;
+    s->score = 0;
+    s->dir = (unsigned char)dir;
+    s->turn = s->dir;
+    s->target = c;
+    if (!push_head(a, i, c)) return 0;
+    
+    s->alive = 1;
+    a->alive++;
+    return 1;
+}
+
+int place_food(Arena *a, Cell c) {
+    if (a->food_count >= a->food_target || a->occupant[c] != ARENA_EMPTY) return 0;
+    
+    add_food(a, c);
+    return 1;
+}
+
+void top_up_food(Arena *a) {
+    a->food_added = 0;
+    while (a->food_count < a->food_target && a->free_count > 0) {
+        add_food(a, a->free_cells[rng_bounded(&a->rng, (uint32_t)a->free_count)]);
+        a->food_added++;
+    }
+}
+
+void steer_snake(Arena *a, int i, Direction dir) {
+    ArenaSnake *s = &a->snakes[i];
+    
+    s->human = 1;
+    s->turn = (unsigned char)dir;
+}
+
+int leaves_tail(const ArenaSnake *s) {
+    return s->grow == 0;
+}
+
+int blocked(Arena *a, Cell c) {
+    int32_t owner = a->occupant[c];
+    if (owner <= 0) return 0;
+    
+    const ArenaSnake *s = &a->snakes[owner - 1];
+    return c != s->body[s->tail] || !leaves_tail(s);
+}
+
+int arena_distance(const Board *b, Cell from, Cell to) {
+    int dx = abs(cell_x(b, from) - cell_x(b, to));
+    int dy = abs(cell_y(b, from) - cell_y(b, to));
+    
+    return (dx < b->width - dx ? dx : b->width - dx) + (dy < b->height - dy ? dy : b->height - dy);
+}
+
+Direction steer_toward(Arena *a, ArenaSnake *s) {
+    const Board *b = a->board;
+    Cell head = s->body[s->head];
+    Direction best = (Direction)s->dir;
+    int best_distance = -1;
+    
+    for (int d = UP; d <= RIGHT; d++) {
+        if (is_reverse((Direction)d, (Direction)s->dir)) continue;
+        
+        Cell c = next_cell(b, head, (Direction)d);
+        int32_t owner = a->occupant[c];
+        if (owner > 0 && (owner != (int32_t)(s - a->snakes) + 1 || c != s->body[s->tail])) continue;
+        
+        int distance = arena_distance(b, c, s->target);
+        if (best_distance < 0 || distance < best_distance) {
+            best = (Direction)d;
+            best_distance = distance;
+        }
+    }
+    
+    return best;
+}
+
+Direction plan_snake(Arena *a, int i) {
+    ArenaSnake *s = &a->snakes[i];
+    
+    if (a->occupant[s->target] != ARENA_FOOD && a->food_count > 0) {
+        s->target = a->food[rng_bounded(&a->rng, (uint32_t)a->food_count)];
+    }
+    return steer_toward(a, s);
+}
+
+void plan_arena(Arena *a) {
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        if (!s->alive || s->human) continue;
+        
+        s->turn = (unsigned char)plan_snake(a, i);
+    }
+}
+
+int step_arena(Arena *a) {
+    const Board *b = a->board;
+    uint32_t first = ++a->tick * 2;
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        s->move = 0;
+        s->spawned = 0;
+        if (!s->alive) continue;
+        
+        if (!is_reverse((Direction)s->turn, (Direction)s->dir) || s->length == 1) {
+            s->dir = s->turn;
+        }
+        s->move = (unsigned char)(ARENA_MOVE_MOVED | s->dir);
+        s->next = next_cell(b, s->body[s->head], (Direction)s->dir);
+        a->claim[s->next] = a->claim[s->next] == first || a->claim[s->next] == first + 1 ? first + 1 : first;
+    }
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        if (!s->alive) continue;
+        
+        s->hit = a->claim[s->next] != first || blocked(a, s->next);
+    }
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        if (!s->alive) continue;
+        
+        if (leaves_tail(s)) {
+            pop_tail(a, s);
+        }
+        else {
+            s->grow--;
+            s->move |= ARENA_MOVE_KEPT;
+        }
+    }
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        if (!s->alive) continue;
+        
+        if (s->hit || !push_head(a, i, s->next)) {
+            kill_snake(a, s);
+            s->move |= ARENA_MOVE_DIED;
+        }
+    }
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        if (!a->snakes[i].alive) {
+            a->snakes[i].spawned = (unsigned char)spawn_snake(a, i);
+        }
+    }
+    
+    top_up_food(a);
+    return a->alive;
+}
+
+int apply_moves(Arena *a) {
+    const Board *b = a->board;
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        if (!(s->move & ARENA_MOVE_MOVED)) continue;
+        if (!s->alive) return 0;
+        
+        s->dir = s->move & ARENA_MOVE_DIR;
+        s->next = next_cell(b, s->body[s->head], (Direction)s->dir);
+        if (leaves_tail(s) == !!(s->move & ARENA_MOVE_KEPT)) return 0;
+        
+        if (leaves_tail(s)) {
+            pop_tail(a, s);
+        }
+        else {
+            s->grow--;
+        }
+    }
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        if (!(s->move & ARENA_MOVE_MOVED)) continue;
+        
+        if (s->move & ARENA_MOVE_DIED) {
+            kill_snake(a, s);
+        }
+        else if (a->occupant[s->next] > 0 || !push_head(a, i, s->next)) {
+            return 0;
+        }
+    }
+    
+    a->tick++;
+    return 1;
+}
+
+int arena_length(const Arena *a) {
+    int total = 0;
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        total += a->snakes[i].length;
+    }
+    return total;
+}
@@ -0,0 +1,69 @@
+#ifndef SNAKE_ARENA_H
+#define SNAKE_ARENA_H
+
+#include <stdint.h>
+
+#include "snake_core.h"
+
+#define ARENA_EMPTY 0
+#define ARENA_FOOD -1
+#define ARENA_MAX_SNAKES 65536
+#define ARENA_MOVE_DIR 3
+#define ARENA_MOVE_KEPT 4
+#define ARENA_MOVE_DIED 8
+#define ARENA_MOVE_MOVED 16
+
+typedef struct {
+    Cell *body;
+    int head;
+    int tail;
+    int length;
+    int mask;
+    int grow;
+    int score;
+    int best_length;
+    Cell next;
+    Cell target;
+    unsigned char dir;
+    unsigned char turn;
+    unsigned char alive;
+    unsigned char human;
+    unsigned char hit;
+    unsigned char move;
+    unsigned char spawned;
+} ArenaSnake;
+
+typedef struct {
+    const Board *board;
+    Rng rng;
+    int32_t *occupant;
+    uint32_t *claim;
+    int32_t *slot;
+    Cell *free_cells;
+    int free_count;
+    Cell *food;
+    int food_count;
+    int food_target;
+    int food_added;
+    ArenaSnake *snakes;
+    int snake_count;
+    int alive;
+    uint32_t tick;
+    long deaths;
+} Arena;
+
+int alloc_arena(Arena *a, const Board *b, int snakes, int food);
+int create_arena(Arena *a, const Board *b, int snakes, int food, uint64_t seed);
+void free_arena(Arena *a);
+void clear_arena(Arena *a);
+int place_snake(Arena *a, int i, Cell c, Direction dir);
+int place_food(Arena *a, Cell c);
+int push_head(Arena *a, int i, Cell c);
+int apply_moves(Arena *a);
+void steer_snake(Arena *a, int i, Direction dir);
+Direction plan_snake(Arena *a, int i);
+void plan_arena(Arena *a);
+int step_arena(Arena *a);
+int arena_length(const Arena *a);
+
+#endif
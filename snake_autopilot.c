@@ -0,0 +1,442 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_autopilot.h"
+
+#define RETRY_TICKS 8
+#define JOIN_DIVISOR 8
+#define SEARCH_TIMED 1
+#define SEARCH_STORE 2
+#define SEARCH_CYCLE 4
+
+void sync_body(Autopilot *a, GameState *g);
+int body_on_cycle(Autopilot *a, GameState *g);
+uint32_t cycle_order(Autopilot *a, Cell c);
+uint32_t cycle_distance(Autopilot *a, Cell from, Cell to);
+int cycle_action(Autopilot *a, GameState *g);
+int path_action(Autopilot *a, GameState *g);
+int plan_path(Autopilot *a, GameState *g);
+int cycle_path_action(Autopilot *a, GameState *g);
+int fallback_action(Autopilot *a, GameState *g);
+int any_action(GameState *g);
+int reserve_path(Autopilot *a, int length);
+uint32_t heuristic(const Board *b, Cell from, Cell to);
+int push_node(Autopilot *a, uint32_t f, uint32_t depth, Cell cell);
+SearchNode pop_node(Autopilot *a);
+int find_path(Autopilot *a, GameState *g, Cell goal, int flags);
+
+int create_autopilot(Autopilot *a, const Board *board, AutopilotMode mode) {
+    memset(a, 0, sizeof(*a));
+    a->board = board;
+    a->mode = mode;
+    a->mirror = (board->height - 1 - board->height / 2) % 2 != 0;
+    
+    if (mode == AUTOPILOT_PATH) {
+        a->entered = malloc(sizeof(uint32_t) * (size_t)board->cells);
+        a->seen = calloc((size_t)board->cells, sizeof(uint32_t));
+        a->from = malloc((size_t)board->cells);
+        if (!a->entered || !a->seen || !a->from || !reserve_path(a, 64)) {
+            free_autopilot(a);
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+void free_autopilot(Autopilot *a) {
+    free(a->entered);
+    free(a->seen);
+    free(a->from);
+    free(a->path);
+    free(a->undo);
+    free(a->heap);
+    memset(a, 0, sizeof(*a));
+}
+
+void reset_autopilot(Autopilot *a) {
+    a->synced = 0;
+    a->on_cycle = 0;
+    a->join_length = 0;
+    a->join_ticks = 0;
+    a->path_length = 0;
+    a->path_next = 0;
+    a->retry_at = a->clock;
+}
+
+int parse_autopilot_mode(const char *name, AutopilotMode *mode) {
+    if (strcmp(name, "path") == 0) {
+        *mode = AUTOPILOT_PATH;
+        return 1;
+    }
+    if (strcmp(name, "cycle") == 0) {
+        *mode = AUTOPILOT_CYCLE;
+        return 1;
+    }
+    
+    return 0;
+}
+
+int autopilot_action(Autopilot *a, GameState *g) {
+    if (g->status != GAME_RUNNING) return ACTION_NONE;
+    
+    if (a->mode == AUTOPILOT_CYCLE) {
+        return cycle_action(a, g);
+    }
+    
+    sync_body(a, g);
+    return path_action(a, g);
+}
+
+void sync_body(Autopilot *a, GameState *g) {
+    Cell head = segment(g, 0);
+    Cell tail = tail_cell(g);
+    
+    if (a->synced && head == a->last_head) {
+        return;
+    }
+    
+    if (a->synced && g->snake_length > 1 && segment(g, 1) == a->last_head) {
+        a->entered[head] = ++a->clock;
+        a->chain += cycle_distance(a, a->last_head, head);
+        a->chain -= cycle_distance(a, a->last_tail, tail);
+    }
+    else {
+        a->chain = 0;
+        for (int i = g->snake_length - 1; i >= 0; i--) {
+            a->entered[segment(g, i)] = ++a->clock;
+            if (i > 0) a->chain += cycle_distance(a, segment(g, i), segment(g, i - 1));
+        }
+        a->path_length = 0;
+        a->path_next = 0;
+        a->on_cycle = 0;
+        a->anchor = head;
+        a->synced = 1;
+    }
+    
+    a->last_head = head;
+    a->last_tail = tail;
+}
+
+int body_on_cycle(Autopilot *a, GameState *g) {
+    uint32_t gap = cycle_distance(a, segment(g, 0), tail_cell(g));
+    
+    return g->snake_length > 1 && a->chain + gap == (uint32_t)a->board->cells;
+}
+
+uint32_t cycle_order(Autopilot *a, Cell c) {
+    const Board *b = a->board;
+    int x = cell_x(b, c);
+    int y = cell_y(b, c);
+    
+    if (a->mirror) x = b->width - 1 - x;
+    if (x == 0) return (uint32_t)y;
+    
+    int row = b->height - 1 - y;
+    int offset = row % 2 == 0 ? x - 1 : b->width - 1 - x;
+    return (uint32_t)(b->height + row * (b->width - 1) + offset);
+}
+
+uint32_t cycle_distance(Autopilot *a, Cell from, Cell to) {
+    uint32_t cells = (uint32_t)a->board->cells;
+    
+    return (cycle_order(a, to) + cells - cycle_order(a, from)) % cells;
+}
+
+int cycle_action(Autopilot *a, GameState *g) {
+    Cell head = segment(g, 0);
+    uint32_t tail = cycle_distance(a, head, tail_cell(g));
+    uint32_t food = cycle_distance(a, head, g->food);
+    uint32_t best_distance = 0;
+    int best = ACTION_NONE;
+    
+    for (int d = UP; d <= RIGHT; d++) {
+        Cell n = next_cell(a->board, head, (Direction)d);
+        uint32_t distance = cycle_distance(a, head, n);
+        
+        if (distance <= best_distance || (distance >= tail && distance != 1)) continue;
+        if (food < tail && distance > food) continue;
+        if (is_reverse((Direction)d, (Direction)g->current_dir)) continue;
+        if (check_collision(g, n, n == g->food)) continue;
+        
+        best = d;
+        best_distance = distance;
+    }
+    
+    return best != ACTION_NONE ? best : any_action(g);
+}
+
+int path_action(Autopilot *a, GameState *g) {
+    if (!a->on_cycle && g->snake_length * JOIN_DIVISOR >= a->board->cells) {
+        if (g->snake_length != a->join_length) {
+            a->join_length = g->snake_length;
+            a->join_ticks = 0;
+        }
+        
+        if (body_on_cycle(a, g)) {
+            a->on_cycle = 1;
+            a->path_length = 0;
+        }
+        else if (++a->join_ticks <= a->board->cells) {
+            return fallback_action(a, g);
+        }
+    }
+    if (a->on_cycle) {
+        return cycle_path_action(a, g);
+    }
+    
+    if (a->path_next < a->path_length && a->target == g->food) {
+        int d = a->path[a->path_next];
+        Cell n = next_cell(a->board, segment(g, 0), (Direction)d);
+        
+        if (!check_collision(g, n, n == g->food)) {
+            a->path_next++;
+            a->anchor = n;
+            return d;
+        }
+    }
+    
+    a->path_length = 0;
+    a->path_next = 0;
+    
+    if (a->target != g->food || (int32_t)(a->clock - a->retry_at) >= 0) {
+        if (plan_path(a, g)) {
+            a->path_next = 1;
+            a->anchor = next_cell(a->board, segment(g, 0), (Direction)a->path[0]);
+            return a->path[0];
+        }
+        
+        a->target = g->food;
+        a->retry_at = a->clock + RETRY_TICKS;
+    }
+    
+    return fallback_action(a, g);
+}
+
+int plan_path(Autopilot *a, GameState *g) {
+    int length = find_path(a, g, g->food, SEARCH_TIMED | SEARCH_STORE);
+    if (length <= 0) return 0;
+    
+    int steps = 0;
+    while (steps < length && g->status == GAME_RUNNING) {
+        step_undoable(g, a->path[steps], &a->undo[steps]);
+        steps++;
+    }
+    
+    int safe = g->status == GAME_WON ||
+               (g->status == GAME_RUNNING && find_path(a, g, tail_cell(g), 0) >= 0);
+    
+    while (steps > 0) {
+        steps--;
+        undo_step(g, &a->undo[steps]);
+    }
+    
+    if (!safe) return 0;
+    
+    a->target = g->food;
+    a->path_length = length;
+    return 1;
+}
+
+int cycle_path_action(Autopilot *a, GameState *g) {
+    if (a->path_next >= a->path_length || a->target != g->food) {
+        a->path_next = 0;
+        a->path_length = find_path(a, g, g->food, SEARCH_STORE | SEARCH_CYCLE);
+        a->target = g->food;
+    }
+    
+    if (a->path_next < a->path_length) {
+        int d = a->path[a->path_next];
+        Cell n = next_cell(a->board, segment(g, 0), (Direction)d);
+        
+        if (!check_collision(g, n, n == g->food)) {
+            a->path_next++;
+            return d;
+        }
+    }
+    
+    a->path_length = 0;
+    return cycle_action(a, g);
+}
+
+int fallback_action(Autopilot *a, GameState *g) {
+    Cell head = segment(g, 0);
+    uint32_t base = cycle_distance(a, a->anchor, head);
+    int best = ACTION_NONE;
+    int best_forward = 0;
+    uint32_t best_distance = 0;
+    
+    for (int d = UP; d <= RIGHT; d++) {
+        Cell n = next_cell(a->board, head, (Direction)d);
+        if (is_reverse((Direction)d, (Direction)g->current_dir)) continue;
+        if (check_collision(g, n, n == g->food)) continue;
+        
+        StepUndo u;
+        step_undoable(g, d, &u);
+        int length = g->status == GAME_WON ? a->board->cells : -1;
+        if (g->status == GAME_RUNNING) {
+            length = find_path(a, g, tail_cell(g), 0);
+        }
+        undo_step(g, &u);
+        
+        if (length < 0) continue;
+        
+        uint32_t distance = cycle_distance(a, a->anchor, n);
+        int forward = distance > base;
+        if (!forward) distance = cycle_distance(a, head, n);
+        
+        if (best == ACTION_NONE || forward > best_forward ||
+            (forward == best_forward && distance < best_distance)) {
+            best = d;
+            best_forward = forward;
+            best_distance = distance;
+        }
+    }
+    
+    if (best == ACTION_NONE) return any_action(g);
+    if (!best_forward) a->anchor = next_cell(a->board, head, (Direction)best);
+    return best;
+}
+
+int any_action(GameState *g) {
+    Cell head = segment(g, 0);
+    
+    for (int d = UP; d <= RIGHT; d++) {
+        Cell n = next_cell(g->board, head, (Direction)d);
+        if (is_reverse((Direction)d, (Direction)g->current_dir)) continue;
+        if (!check_collision(g, n, n == g->food)) return d;
+    }
+    
+    return ACTION_NONE;
+}
+
+int reserve_path(Autopilot *a, int length) {
+    if (length <= a->path_capacity) return 1;
+    
+    int capacity = a->path_capacity > 0 ? a->path_capacity : 64;
+    while (capacity < length) {
+        capacity *= 2;
+    }
+    
+    unsigned char *path = realloc(a->path, (size_t)capacity);
+    if (!path) return 0;
+    a->path = path;
+    
+    StepUndo *undo = realloc(a->undo, sizeof(StepUndo) * (size_t)capacity);
+    if (!undo) return 0;
+    a->undo = undo;
+    
+    a->path_capacity = capacity;
+    return 1;
+}
+
+uint32_t heuristic(const Board *b, Cell from, Cell to) {
+    int dx = abs(cell_x(b, from) - cell_x(b, to));
+    int dy = abs(cell_y(b, from) - cell_y(b, to));
+    
+    if (dx > b->width - dx) dx = b->width - dx;
+    if (dy > b->height - dy) dy = b->height - dy;
+    return (uint32_t)(dx + dy);
+}
+
+int push_node(Autopilot *a, uint32_t f, uint32_t depth, Cell cell) {
+    if (a->heap_count == a->heap_capacity) {
+        int capacity = a->heap_capacity > 0 ? a->heap_capacity * 2 : 256;
+        SearchNode *heap = realloc(a->heap, sizeof(SearchNode) * (size_t)capacity);
+        if (!heap) return 0;
+        a->heap = heap;
+        a->heap_capacity = capacity;
+    }
+    
+    SearchNode node = {f, depth, cell};
+    int i = a->heap_count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        SearchNode *p = &a->heap[parent];
+        if (p->f < f || (p->f == f && p->depth >= depth)) break;
+        
+        a->heap[i] = *p;
+        i = parent;
+    }
+    a->heap[i] = node;
+    return 1;
+}
+
+SearchNode pop_node(Autopilot *a) {
+    SearchNode top = a->heap[0];
+    SearchNode last = a->heap[--a->heap_count];
+    int i = 0;
+    
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= a->heap_count) break;
+        
+        SearchNode *c = &a->heap[child];
+        if (child + 1 < a->heap_count) {
+            SearchNode *r = &a->heap[child + 1];
+            if (r->f < c->f || (r->f == c->f && r->depth > c->depth)) {
+                child++;
+                c = r;
+            }
+        }
+        if (last.f < c->f || (last.f == c->f && last.depth >= c->depth)) break;
+        
+        a->heap[i] = *c;
+        i = child;
+    }
+    a->heap[i] = last;
+    return top;
+}
+
+int find_path(Autopilot *a, GameState *g, Cell goal, int flags) {
+    const Board *b = a->board;
+    Cell head = segment(g, 0);
+    uint32_t tail_time = a->entered[tail_cell(g)];
+    uint32_t tail_distance = cycle_distance(a, head, tail_cell(g));
+    
+    if (++a->stamp == 0) {
+        memset(a->seen, 0, sizeof(uint32_t) * (size_t)b->cells);
+        a->stamp = 1;
+    }
+    
+    a->heap_count = 0;
+    a->seen[head] = a->stamp;
+    if (!push_node(a, heuristic(b, head, goal), 0, head)) return -1;
+    
+    while (a->heap_count > 0) {
+        SearchNode node = pop_node(a);
+        
+        if (node.cell == goal) {
+            int length = (int)node.depth;
+            if (flags & SEARCH_STORE) {
+                if (!reserve_path(a, length)) return -1;
+                
+                Cell c = goal;
+                for (int k = length - 1; k >= 0; k--) {
+                    a->path[k] = a->from[c];
+                    c = next_cell(b, c, (Direction)(a->from[c] ^ 1));
+                }
+            }
+            return length;
+        }
+        
+        uint32_t distance = flags & SEARCH_CYCLE ? cycle_distance(a, head, node.cell) : 0;
+        for (int d = UP; d <= RIGHT; d++) {
+            Cell n = next_cell(b, node.cell, (Direction)d);
+            if (a->seen[n] == a->stamp) continue;
+            if (flags & SEARCH_CYCLE) {
+                uint32_t next = cycle_distance(a, head, n);
+                if (next <= distance || next >= tail_distance) continue;
+            }
+            if (cell_occupied(g, n) && n != goal) {
+                if (!(flags & SEARCH_TIMED) || a->entered[n] - tail_time > node.depth) continue;
+            }
+            
+            a->seen[n] = a->stamp;
+            a->from[n] = (unsigned char)d;
+            if (!push_node(a, node.depth + 1 + heuristic(b, n, goal), node.depth + 1, n)) return -1;
+        }
+    }
+    
+    return -1;
+}
\ No newline at end of file
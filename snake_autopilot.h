@@ -0,0 +1,54 @@
+#ifndef SNAKE_AUTOPILOT_H
+#define SNAKE_AUTOPILOT_H
+
+#include <stdint.h>
+
+#include "snake_core.h"
+
+typedef enum {
+    AUTOPILOT_PATH,
+    AUTOPILOT_CYCLE
+} AutopilotMode;
+
+typedef struct {
+    uint32_t f;
+    uint32_t depth;
+    Cell cell;
+} SearchNode;
+
+typedef struct {
+    const Board *board;
+    AutopilotMode mode;
+    int mirror;
+    int synced;
+    int on_cycle;
+    Cell last_head;
+    Cell last_tail;
+    Cell anchor;
+    uint32_t chain;
+    int join_length;
+    int join_ticks;
+    Cell target;
+    uint32_t clock;
+    uint32_t stamp;
+    uint32_t retry_at;
+    int path_length;
+    int path_next;
+    int path_capacity;
+    int heap_count;
+    int heap_capacity;
+    uint32_t *entered;
+    uint32_t *seen;
+    unsigned char *from;
+    unsigned char *path;
+    StepUndo *undo;
+    SearchNode *heap;
+} Autopilot;
+
+int create_autopilot(Autopilot *a, const Board *board, AutopilotMode mode);
+void free_autopilot(Autopilot *a);
+void reset_autopilot(Autopilot *a);
+int autopilot_action(Autopilot *a, GameState *g);
+int parse_autopilot_mode(const char *name, AutopilotMode *mode);
+
+#endif
@@ -0,0 +1,236 @@
+#include <limits.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#include "snake_batch.h"
+
+#define FLAG_ATE 1
+#define FLAG_HIT 2
+
+void sync_batch_game(GameBatch *b, int i);
+void plan_scalar(GameBatch *b, const int *actions, int from, int to);
+void plan_sse2(GameBatch *b, const int *actions, int from, int to);
+void plan_avx2(GameBatch *b, const int *actions, int from, int to);
+
+int init_batch(GameBatch *b, const Board *board, int count, uint64_t seed) {
+    int32_t **columns[] = {
+        &b->head_cell, &b->tail_cell, &b->food_cell, &b->dir,
+        &b->room, &b->status, &b->new_cell, &b->flags
+    };
+    int column_count = (int)(sizeof(columns) / sizeof(columns[0]));
+    
+    memset(b, 0, sizeof(*b));
+    b->board = board;
+    b->gather_ok = board->neighbor != NULL && (long long)count * board->words * 2 <= INT_MAX;
+    b->bits = alloc_aligned(sizeof(uint64_t) * (size_t)board->words * (size_t)count);
+    b->games = alloc_aligned(sizeof(GameState) * (size_t)count);
+    if (b->games) {
+        memset(b->games, 0, sizeof(GameState) * (size_t)count);
+    }
+    
+    int ok = b->bits != NULL && b->games != NULL;
+    for (int c = 0; c < column_count; c++) {
+        *columns[c] = alloc_aligned(sizeof(int32_t) * (size_t)count);
+        ok = ok && *columns[c] != NULL;
+    }
+    
+    for (int i = 0; ok && i < count; i++) {
+        ok = create_game(&b->games[i], board, &b->bits[(size_t)board->words * (size_t)i]);
+        b->count = i + ok;
+    }
+    
+    if (!ok) {
+        free_batch(b);
+        return 0;
+    }
+    
+    for (int i = 0; i < count; i++) {
+        reset_batch_game(b, i, seed + (uint64_t)i);
+    }
+    
+    return 1;
+}
+
+void free_batch(GameBatch *b) {
+    for (int i = 0; b->games && i < b->count; i++) {
+        free_game(&b->games[i]);
+    }
+    
+    free_aligned(b->head_cell);
+    free_aligned(b->tail_cell);
+    free_aligned(b->food_cell);
+    free_aligned(b->dir);
+    free_aligned(b->room);
+    free_aligned(b->status);
+    free_aligned(b->new_cell);
+    free_aligned(b->flags);
+    free_aligned(b->bits);
+    free_aligned(b->games);
+    memset(b, 0, sizeof(*b));
+}
+
+void sync_batch_game(GameBatch *b, int i) {
+    GameState *g = &b->games[i];
+    
+    b->head_cell[i] = segment(g, 0);
+    b->tail_cell[i] = tail_cell(g);
+    b->food_cell[i] = g->food;
+    b->dir[i] = g->current_dir;
+    b->room[i] = g->snake_mask + 1 - g->snake_length;
+    b->status[i] = g->status;
+}
+
+void reset_batch_game(GameBatch *b, int i, uint64_t seed) {
+    init_game(&b->games[i], seed);
+    sync_batch_game(b, i);
+}
+
+void plan_scalar(GameBatch *b, const int *actions, int from, int to) {
+    for (int i = from; i < to; i++) {
+        int d = b->dir[i];
+        int a = actions ? actions[i] : ACTION_NONE;
+        if (a >= UP && a <= RIGHT && (a ^ d) != 1) {
+            d = a;
+        }
+        
+        Cell c = next_cell(b->board, (Cell)b->head_cell[i], (Direction)d);
+        int ate = c == (Cell)b->food_cell[i];
+        int grow = ate && b->room[i] > 0;
+        int hit = cell_occupied(&b->games[i], c) && !(c == (Cell)b->tail_cell[i] && !grow);
+        
+        b->dir[i] = d;
+        b->new_cell[i] = c;
+        b->flags[i] = b->status[i] == GAME_RUNNING ? (ate ? FLAG_ATE : 0) | (hit ? FLAG_HIT : 0) : 0;
+    }
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+void plan_sse2(GameBatch *b, const int *actions, int from, int to) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i running = _mm_set1_epi32(GAME_RUNNING);
+    const __m128i flag_ate = _mm_set1_epi32(FLAG_ATE);
+    const __m128i flag_hit = _mm_set1_epi32(FLAG_HIT);
+    int i = from;
+    
+    for (; i + 4 <= to; i += 4) {
+        __m128i d = _mm_loadu_si128((const __m128i *)&b->dir[i]);
+        __m128i a = actions ? _mm_loadu_si128((const __m128i *)&actions[i]) : _mm_set1_epi32(ACTION_NONE);
+        __m128i valid = _mm_and_si128(_mm_cmpgt_epi32(a, _mm_set1_epi32(UP - 1)), _mm_cmplt_epi32(a, _mm_set1_epi32(RIGHT + 1)));
+        valid = _mm_andnot_si128(_mm_cmpeq_epi32(_mm_xor_si128(a, d), one), valid);
+        d = _mm_or_si128(_mm_and_si128(valid, a), _mm_andnot_si128(valid, d));
+        
+        int32_t dirs[4];
+        int32_t cells[4];
+        int32_t occupied[4];
+        _mm_storeu_si128((__m128i *)dirs, d);
+        for (int k = 0; k < 4; k++) {
+            cells[k] = (int32_t)next_cell(b->board, (Cell)b->head_cell[i + k], (Direction)dirs[k]);
+            occupied[k] = -cell_occupied(&b->games[i + k], (Cell)cells[k]);
+        }
+        
+        __m128i cell = _mm_loadu_si128((const __m128i *)cells);
+        __m128i ate = _mm_cmpeq_epi32(cell, _mm_loadu_si128((const __m128i *)&b->food_cell[i]));
+        __m128i grow = _mm_and_si128(ate, _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)&b->room[i]), zero));
+        __m128i leaving_tail = _mm_andnot_si128(grow, _mm_cmpeq_epi32(cell, _mm_loadu_si128((const __m128i *)&b->tail_cell[i])));
+        __m128i hit = _mm_andnot_si128(leaving_tail, _mm_loadu_si128((const __m128i *)occupied));
+        __m128i live = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)&b->status[i]), running);
+        __m128i flags = _mm_and_si128(live, _mm_or_si128(_mm_and_si128(ate, flag_ate), _mm_and_si128(hit, flag_hit)));
+        
+        _mm_storeu_si128((__m128i *)&b->dir[i], d);
+        _mm_storeu_si128((__m128i *)&b->new_cell[i], cell);
+        _mm_storeu_si128((__m128i *)&b->flags[i], flags);
+    }
+    
+    plan_scalar(b, actions, i, to);
+}
+#endif
+
+#if defined(__AVX2__)
+void plan_avx2(GameBatch *b, const int *actions, int from, int to) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i running = _mm256_set1_epi32(GAME_RUNNING);
+    const __m256i flag_ate = _mm256_set1_epi32(FLAG_ATE);
+    const __m256i flag_hit = _mm256_set1_epi32(FLAG_HIT);
+    const __m256i bit_mask = _mm256_set1_epi32(31);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i lane_words = _mm256_set1_epi32(b->board->words * 2);
+    const int *neighbor = (const int *)(const void *)b->board->neighbor;
+    const int *bits = (const int *)(const void *)b->bits;
+    int i = from;
+    
+    if (!b->gather_ok) {
+        plan_sse2(b, actions, from, to);
+        return;
+    }
+    
+    for (; i + 8 <= to; i += 8) {
+        __m256i d = _mm256_loadu_si256((const __m256i *)&b->dir[i]);
+        __m256i a = actions ? _mm256_loadu_si256((const __m256i *)&actions[i]) : _mm256_set1_epi32(ACTION_NONE);
+        __m256i valid = _mm256_and_si256(_mm256_cmpgt_epi32(a, _mm256_set1_epi32(UP - 1)),
+                                         _mm256_cmpgt_epi32(_mm256_set1_epi32(RIGHT + 1), a));
+        valid = _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_xor_si256(a, d), one), valid);
+        d = _mm256_blendv_epi8(d, a, valid);
+        
+        __m256i entry = _mm256_add_epi32(_mm256_slli_epi32(_mm256_loadu_si256((const __m256i *)&b->head_cell[i]), 2), d);
+        __m256i cell = _mm256_i32gather_epi32(neighbor, entry, 4);
+        
+        __m256i ate = _mm256_cmpeq_epi32(cell, _mm256_loadu_si256((const __m256i *)&b->food_cell[i]));
+        __m256i grow = _mm256_and_si256(ate, _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i *)&b->room[i]), zero));
+        
+        __m256i lane = _mm256_mullo_epi32(_mm256_add_epi32(_mm256_set1_epi32(i), lanes), lane_words);
+        __m256i occupied = _mm256_i32gather_epi32(bits, _mm256_add_epi32(lane, _mm256_srli_epi32(cell, 5)), 4);
+        occupied = _mm256_srlv_epi32(occupied, _mm256_and_si256(cell, bit_mask));
+        occupied = _mm256_cmpgt_epi32(_mm256_and_si256(occupied, one), zero);
+        
+        __m256i leaving_tail = _mm256_andnot_si256(grow, _mm256_cmpeq_epi32(cell, _mm256_loadu_si256((const __m256i *)&b->tail_cell[i])));
+        __m256i hit = _mm256_andnot_si256(leaving_tail, occupied);
+        __m256i live = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)&b->status[i]), running);
+        __m256i flags = _mm256_and_si256(live, _mm256_or_si256(_mm256_and_si256(ate, flag_ate), _mm256_and_si256(hit, flag_hit)));
+        
+        _mm256_storeu_si256((__m256i *)&b->dir[i], d);
+        _mm256_storeu_si256((__m256i *)&b->new_cell[i], cell);
+        _mm256_storeu_si256((__m256i *)&b->flags[i], flags);
+    }
+    
+    plan_scalar(b, actions, i, to);
+}
+#endif
+
+int step_batch(GameBatch *b, const int *actions) {
+#if defined(__AVX2__)
+    plan_avx2(b, actions, 0, b->count);
+#elif defined(__SSE2__) || defined(_M_X64)
+    plan_sse2(b, actions, 0, b->count);
+#else
+    plan_scalar(b, actions, 0, b->count);
+#endif
+    
+    int running = 0;
+    for (int i = 0; i < b->count; i++) {
+        if (b->status[i] != GAME_RUNNING) continue;
+        
+        GameState *g = &b->games[i];
+        
+        g->current_dir = (unsigned char)b->dir[i];
+        apply_move(g, (Cell)b->new_cell[i], b->flags[i] & FLAG_ATE, b->flags[i] & FLAG_HIT);
+        
+        if (b->flags[i]) {
+            sync_batch_game(b, i);
+        }
+        else {
+            b->head_cell[i] = b->new_cell[i];
+            b->tail_cell[i] = tail_cell(g);
+        }
+        
+        running += g->status == GAME_RUNNING;
+    }
+    
+    return running;
+}
\ No newline at end of file
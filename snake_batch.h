@@ -0,0 +1,29 @@
+#ifndef SNAKE_BATCH_H
+#define SNAKE_BATCH_H
+
+#include <stdint.h>
+
+#include "snake_core.h"
+
+typedef struct {
+    int count;
+    int gather_ok;
+    const Board *board;
+    int32_t *head_cell;
+    int32_t *tail_cell;
+    int32_t *food_cell;
+    int32_t *dir;
+    int32_t *room;
+    int32_t *status;
+    int32_t *new_cell;
+    int32_t *flags;
+    uint64_t *bits;
+    GameState *games;
+} GameBatch;
+
+int init_batch(GameBatch *b, const Board *board, int count, uint64_t seed);
+void free_batch(GameBatch *b);
+void reset_batch_game(GameBatch *b, int i, uint64_t seed);
+int step_batch(GameBatch *b, const int *actions);
+
+#endif
@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snake_core.h"
+#include "snake_autopilot.h"
+#include "snake_view.h"
+
+#define MOVE_BATCH 1024
+#define PROBE_CELLS 4096
+#define SPAWN_BATCH 256
+#define FRAME_BATCH 64
+#define DEFAULT_MIN_MS 200
+#define DEFAULT_LOOP_GAMES 20
+#define BENCH_SEED 1
+
+typedef struct {
+    const char *name;
+    int length;
+    long long ops;
+    double ns_per_op;
+    long allocs;
+} BenchResult;
+
+typedef struct {
+    const char *name;
+    long games;
+    long long ticks;
+    double seconds;
+    long allocs;
+} LoopResult;
+
+typedef struct {
+    long long bytes;
+    char last;
+} FrameSink;
+
+typedef struct {
+    GameState game;
+    Autopilot pilot;
+    View view;
+    FrameSink sink;
+    void *saved;
+    int actions[MOVE_BATCH];
+    int moves;
+    Cell probes[PROBE_CELLS];
+    double min_seconds;
+} Bench;
+
+#if defined(COUNT_ALLOCS)
+long alloc_count;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *p, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+void *__wrap_malloc(size_t size) {
+    alloc_count++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    alloc_count++;
+    return __real_calloc(count, size);
+}
+
+void *__wrap_realloc(void *p, size_t size) {
+    alloc_count++;
+    return __real_realloc(p, size);
+}
+
+void *__wrap_aligned_alloc(size_t alignment, size_t size) {
+    alloc_count++;
+    return __real_aligned_alloc(alignment, size);
+}
+
+#define ALLOCS() alloc_count
+#define ALLOCS_SINCE(start) (alloc_count - (start))
+#else
+#define ALLOCS() -1L
+#define ALLOCS_SINCE(start) ((void)(start), -1L)
+#endif
+
+void sink_frame(void *context, const char *text, int length);
+void sink_text(void *context, int x, int y, const char *text, int length);
+double now_seconds();
+int prepare_length(Bench *b, int length);
+void bench_moves(Bench *b, BenchResult *r);
+void bench_collisions(Bench *b, BenchResult *r);
+void bench_spawns(Bench *b, BenchResult *r);
+void bench_full_frames(Bench *b, BenchResult *r);
+void bench_diff_frames(Bench *b, BenchResult *r, const BenchResult *moves);
+void bench_loop(const Board *board, LoopResult *r, long games, int draw);
+void print_results(const Board *board, BenchResult *results, int count, LoopResult *loops, int loop_count, int json);
+const char *format_allocs(long allocs, char *buffer);
+
+int main(int argc, char *argv[]) {
+    int width = DEFAULT_WIDTH;
+    int height = DEFAULT_HEIGHT;
+    int json = 0;
+    long games = DEFAULT_LOOP_GAMES;
+    long min_ms = DEFAULT_MIN_MS;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--min-ms") == 0 && i + 1 < argc) {
+            min_ms = atol(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--json] [--width N] [--height N] [--games N] [--min-ms N]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    Board board;
+    if (!create_board(&board, width, height)) {
+        fprintf(stderr, "board must be between %d and %d cells on each side\n", MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        return 1;
+    }
+    
+    Bench *b = alloc_aligned(sizeof(Bench));
+    ViewSink sink = {NULL, sink_frame, sink_text};
+    if (b) {
+        memset(b, 0, sizeof(*b));
+    }
+    if (!b || !create_game(&b->game, &board, NULL) || !create_autopilot(&b->pilot, &board, AUTOPILOT_PATH)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    sink.context = &b->sink;
+    if (!create_view(&b->view, &board, width + 2, height + 4, sink)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    b->min_seconds = min_ms / 1000.0;
+    
+    int lengths[4] = {3, 50, 250, 449};
+    BenchResult results[20];
+    int count = 0;
+    for (int i = 0; i < 4; i++) {
+        if (lengths[i] >= board.cells || !prepare_length(b, lengths[i])) continue;
+        
+        bench_moves(b, &results[count]);
+        bench_collisions(b, &results[count + 1]);
+        bench_spawns(b, &results[count + 2]);
+        bench_full_frames(b, &results[count + 3]);
+        bench_diff_frames(b, &results[count + 4], &results[count]);
+        count += 5;
+        free(b->saved);
+        b->saved = NULL;
+    }
+    
+    LoopResult loops[2];
+    bench_loop(&board, &loops[0], games, 0);
+    bench_loop(&board, &loops[1], games, 1);
+    
+    print_results(&board, results, count, loops, 2, json);
+    
+    free_view(&b->view);
+    free_autopilot(&b->pilot);
+    free_game(&b->game);
+    free_aligned(b);
+    free_board(&board);
+    return 0;
+}
+
+void sink_frame(void *context, const char *text, int length) {
+    FrameSink *s = context;
+    
+    s->bytes += length;
+    s->last = text[length - 1];
+}
+
+void sink_text(void *context, int x, int y, const char *text, int length) {
+    FrameSink *s = context;
+    
+    s->bytes += length + x + y;
+    s->last = text[length - 1];
+}
+
+double now_seconds() {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+int prepare_length(Bench *b, int length) {
+    GameState *g = &b->game;
+    
+    init_game(g, BENCH_SEED);
+    reset_autopilot(&b->pilot);
+    while (g->snake_length < length && g->status == GAME_RUNNING) {
+        step(g, autopilot_action(&b->pilot, g));
+    }
+    if (g->status != GAME_RUNNING) return 0;
+    
+    b->saved = malloc(snapshot_size(g));
+    if (!b->saved) return 0;
+    snapshot(g, b->saved);
+    
+    b->moves = 0;
+    while (b->moves < MOVE_BATCH && g->status == GAME_RUNNING) {
+        int action = autopilot_action(&b->pilot, g);
+        b->actions[b->moves++] = action;
+        step(g, action);
+    }
+    
+    Rng rng;
+    rng_seed(&rng, BENCH_SEED);
+    for (int i = 0; i < PROBE_CELLS; i++) {
+        b->probes[i] = rng_bounded(&rng, (uint32_t)g->board->cells);
+    }
+    
+    restore(g, b->saved);
+    return 1;
+}
+
+void bench_moves(Bench *b, BenchResult *r) {
+    GameState *g = &b->game;
+    double elapsed = 0;
+    long long ops = 0;
+    long allocs = ALLOCS();
+    
+    while (elapsed < b->min_seconds) {
+        restore(g, b->saved);
+        double start = now_seconds();
+        for (int i = 0; i < b->moves; i++) {
+            step(g, b->actions[i]);
+        }
+        elapsed += now_seconds() - start;
+        ops += b->moves;
+    }
+    
+    restore(g, b->saved);
+    r->name = "move_snake";
+    r->length = g->snake_length;
+    r->ops = ops;
+    r->ns_per_op = elapsed * 1e9 / ops;
+    r->allocs = ALLOCS_SINCE(allocs);
+}
+
+void bench_collisions(Bench *b, BenchResult *r) {
+    GameState *g = &b->game;
+    double elapsed = 0;
+    long long ops = 0;
+    long allocs = ALLOCS();
+    volatile int hits = 0;
+    
+    restore(g, b->saved);
+    while (elapsed < b->min_seconds) {
+        int sum = 0;
+        double start = now_seconds();
+        for (int i = 0; i < PROBE_CELLS; i++) {
+            sum += check_collision(g, b->probes[i], 0);
+        }
+        elapsed += now_seconds() - start;
+        hits += sum;
+        ops += PROBE_CELLS;
+    }
+    
+    r->name = "check_collision";
+    r->length = g->snake_length;
+    r->ops = ops;
+    r->ns_per_op = elapsed * 1e9 / ops;
+    r->allocs = ALLOCS_SINCE(allocs);
+}
+
+void bench_spawns(Bench *b, BenchResult *r) {
+    GameState *g = &b->game;
+    double elapsed = 0;
+    long long ops = 0;
+    long allocs = ALLOCS();
+    
+    restore(g, b->saved);
+    while (elapsed < b->min_seconds) {
+        double start = now_seconds();
+        for (int i = 0; i < SPAWN_BATCH; i++) {
+            spawn_food(g);
+        }
+        elapsed += now_seconds() - start;
+        ops += SPAWN_BATCH;
+    }
+    
+    r->name = "spawn_food";
+    r->length = g->snake_length;
+    r->ops = ops;
+    r->ns_per_op = elapsed * 1e9 / ops;
+    r->allocs = ALLOCS_SINCE(allocs);
+    restore(g, b->saved);
+}
+
+void bench_full_frames(Bench *b, BenchResult *r) {
+    GameState *g = &b->game;
+    double elapsed = 0;
+    long long ops = 0;
+    long allocs = ALLOCS();
+    
+    restore(g, b->saved);
+    while (elapsed < b->min_seconds) {
+        double start = now_seconds();
+        for (int i = 0; i < FRAME_BATCH; i++) {
+            draw_view(&b->view, g, 1);
+        }
+        elapsed += now_seconds() - start;
+        ops += FRAME_BATCH;
+    }
+    
+    r->name = "draw_game_full";
+    r->length = g->snake_length;
+    r->ops = ops;
+    r->ns_per_op = elapsed * 1e9 / ops;
+    r->allocs = ALLOCS_SINCE(allocs);
+}
+
+void bench_diff_frames(Bench *b, BenchResult *r, const BenchResult *moves) {
+    GameState *g = &b->game;
+    double elapsed = 0;
+    long long ops = 0;
+    long allocs = ALLOCS();
+    
+    while (elapsed < b->min_seconds) {
+        restore(g, b->saved);
+        draw_view(&b->view, g, 1);
+        
+        double start = now_seconds();
+        for (int i = 0; i < b->moves; i++) {
+            step(g, b->actions[i]);
+            draw_view(&b->view, g, 0);
+        }
+        elapsed += now_seconds() - start;
+        ops += b->moves;
+    }
+    
+    double ns = elapsed * 1e9 / ops - moves->ns_per_op;
+    r->name = "draw_game_diff";
+    r->length = moves->length;
+    r->ops = ops;
+    r->ns_per_op = ns > 0 ? ns : 0;
+    r->allocs = ALLOCS_SINCE(allocs);
+    restore(g, b->saved);
+}
+
+void bench_loop(const Board *board, LoopResult *r, long games, int draw) {
+    GameState g;
+    Autopilot a;
+    View view;
+    FrameSink frames = {0};
+    ViewSink sink = {&frames, sink_frame, sink_text};
+    
+    memset(r, 0, sizeof(*r));
+    r->name = draw ? "game_loop_render" : "game_loop_headless";
+    if (!create_game(&g, board, NULL)) return;
+    if (!create_autopilot(&a, board, AUTOPILOT_PATH)) {
+        free_game(&g);
+        return;
+    }
+    if (!create_view(&view, board, board->width + 2, board->height + 4, sink)) {
+        free_autopilot(&a);
+        free_game(&g);
+        return;
+    }
+    
+    long allocs = ALLOCS();
+    double start = now_seconds();
+    for (long n = 0; n < games; n++) {
+        init_game(&g, BENCH_SEED + n);
+        reset_autopilot(&a);
+        while (g.status == GAME_RUNNING) {
+            step(&g, autopilot_action(&a, &g));
+            if (draw) draw_view(&view, &g, 0);
+            r->ticks++;
+        }
+    }
+    r->seconds = now_seconds() - start;
+    r->allocs = ALLOCS_SINCE(allocs);
+    r->games = games;
+    
+    free_view(&view);
+    free_autopilot(&a);
+    free_game(&g);
+}
+
+void print_results(const Board *board, BenchResult *results, int count, LoopResult *loops, int loop_count, int json) {
+    char allocs[24];
+    
+    if (!json) {
+        printf("board %d x %d\n", board->width, board->height);
+        printf("%-20s %7s %12s %10s %8s\n", "benchmark", "length", "ops", "ns/op", "allocs");
+        for (int i = 0; i < count; i++) {
+            BenchResult *r = &results[i];
+            printf("%-20s %7d %12lld %10.2f %8s\n", r->name, r->length, r->ops, r->ns_per_op, format_allocs(r->allocs, allocs));
+        }
+        printf("%-20s %7s %12s %10s %8s\n", "loop", "games", "ticks", "ticks/sec", "allocs");
+        for (int i = 0; i < loop_count; i++) {
+            LoopResult *l = &loops[i];
+            printf("%-20s %7ld %12lld %10.0f %8s\n", l->name, l->games, l->ticks,
+                   l->seconds > 0 ? l->ticks / l->seconds : 0.0, format_allocs(l->allocs, allocs));
+        }
+        return;
+    }
+    
+    printf("{\n  \"board\": {\"width\": %d, \"height\": %d},\n  \"benchmarks\": [\n", board->width, board->height);
+    for (int i = 0; i < count; i++) {
+        BenchResult *r = &results[i];
+        printf("    {\"name\": \"%s\", \"length\": %d, \"ops\": %lld, \"ns_per_op\": %.3f, \"allocs\": %s}%s\n",
+               r->name, r->length, r->ops, r->ns_per_op, format_allocs(r->allocs, allocs), i + 1 < count ? "," : "");
+    }
+    printf("  ],\n  \"loops\": [\n");
+    for (int i = 0; i < loop_count; i++) {
+        LoopResult *l = &loops[i];
+        printf("    {\"name\": \"%s\", \"games\": %ld, \"ticks\": %lld, \"seconds\": %.6f, \"ticks_per_sec\": %.0f, \"allocs\": %s}%s\n",
+               l->name, l->games, l->ticks, l->seconds, l->seconds > 0 ? l->ticks / l->seconds : 0.0,
+               format_allocs(l->allocs, allocs), i + 1 < loop_count ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+const char *format_allocs(long allocs, char *buffer) {
+    if (allocs < 0) return "null";
+    
+    sprintf(buffer, "%ld", allocs);
+    return buffer;
+}
\ No newline at end of file
@@ -0,0 +1,206 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "snake_core.h"
+#include "snake_arena.h"
+#include "snake_net.h"
+
+#define READ_CHUNK 65536
+
+typedef struct {
+    int fd;
+    NetMirror mirror;
+    NetBuffer in;
+    NetBuffer out;
+    int bot;
+    int waiting;
+    long deltas;
+    long snapshots;
+    long resyncs;
+    long long delta_bytes;
+    long long bytes;
+} Client;
+
+int connect_server(const char *host, const char *port);
+int send_all(Client *c);
+void steer_bot(Client *c);
+int handle_message(Client *c, int type, NetReader *r, size_t size);
+int run_client(Client *c, long max_ticks);
+
+int main(int argc, char *argv[]) {
+    const char *host = "127.0.0.1";
+    const char *port = "7777";
+    long max_ticks = 0;
+    Client client = {0};
+    
+    client.bot = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        }
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = argv[++i];
+        }
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            max_ticks = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--idle") == 0) {
+            client.bot = 0;
+        }
+        else {
+            fprintf(stderr, "usage: %s [--host HOST] [--port N] [--ticks N] [--idle]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    init_mirror(&client.mirror);
+    client.fd = connect_server(host, port);
+    if (client.fd < 0) {
+        fprintf(stderr, "could not connect to %s:%s\n", host, port);
+        return 1;
+    }
+    
+    int ok = run_client(&client, max_ticks);
+    NetMirror *m = &client.mirror;
+    printf("snake %d ticks %ld snapshots %ld resyncs %ld received %lld bytes\n",
+           m->snake, client.deltas, client.snapshots, client.resyncs, client.bytes);
+    if (client.deltas > 0 && m->arena.snake_count > 0) {
+        printf("delta %.1f bytes/tick (%.3f per snake) score %d\n",
+               (double)client.delta_bytes / client.deltas,
+               (double)client.delta_bytes / client.deltas / m->arena.snake_count,
+               m->snake >= 0 ? m->arena.snakes[m->snake].score : 0);
+    }
+    
+    close(client.fd);
+    free_net_buffer(&client.in);
+    free_net_buffer(&client.out);
+    free_mirror(m);
+    return ok ? 0 : 1;
+}
+
+int connect_server(const char *host, const char *port) {
+    struct addrinfo hints;
+    struct addrinfo *found;
+    int fd = -1;
+    
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &found) != 0) return -1;
+    
+    for (struct addrinfo *ai = found; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    
+    if (fd >= 0) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+    return fd;
+}
+
+int send_all(Client *c) {
+    size_t sent = 0;
+    
+    while (sent < c->out.size) {
+        ssize_t put = send(c->fd, c->out.data + sent, c->out.size - sent, MSG_NOSIGNAL);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        sent += (size_t)put;
+    }
+    
+    c->out.size = 0;
+    return 1;
+}
+
+void steer_bot(Client *c) {
+    NetMirror *m = &c->mirror;
+    
+    if (!c->bot || !m->ready || m->snake < 0 || !m->arena.snakes[m->snake].alive) return;
+    
+    Direction dir = plan_snake(&m->arena, m->snake);
+    if (dir != (Direction)m->arena.snakes[m->snake].dir) {
+        put_message(&c->out, NET_TURN, (uint32_t)dir);
+    }
+}
+
+int handle_message(Client *c, int type, NetReader *r, size_t size) {
+    NetMirror *m = &c->mirror;
+    uint32_t value;
+    
+    switch (type) {
+        case NET_WELCOME:
+            if (!net_get_varint(r, &value) || value >= ARENA_MAX_SNAKES) return 0;
+            
+            m->snake = (int)value;
+            return 1;
+        case NET_SNAPSHOT:
+            c->snapshots++;
+            c->waiting = 0;
+            return decode_snapshot(m, r);
+        case NET_DELTA:
+            if (c->waiting) return 1;
+            
+            c->deltas++;
+            c->delta_bytes += (long long)size;
+            if (!decode_delta(m, r)) {
+                c->resyncs++;
+                c->waiting = 1;
+                return put_message(&c->out, NET_RESYNC, m->arena.tick);
+            }
+            
+            steer_bot(c);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int run_client(Client *c, long max_ticks) {
+    if (!put_message(&c->out, c->bot ? NET_HELLO : NET_WATCH, NET_VERSION) || !send_all(c)) return 0;
+    
+    while (max_ticks == 0 || c->deltas < max_ticks) {
+        if (!net_reserve(&c->in, READ_CHUNK)) return 0;
+        
+        ssize_t got = recv(c->fd, c->in.data + c->in.size, c->in.capacity - c->in.size, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return got == 0;
+        
+        c->in.size += (size_t)got;
+        c->bytes += got;
+        
+        size_t pos = 0;
+        for (;;) {
+            int type;
+            NetReader payload;
+            long used = next_message(c->in.data + pos, c->in.size - pos, &type, &payload);
+            if (used < 0) return 0;
+            if (used == 0) break;
+            
+            if (!handle_message(c, type, &payload, (size_t)used)) return 0;
+            pos += (size_t)used;
+        }
+        
+        memmove(c->in.data, c->in.data + pos, c->in.size - pos);
+        c->in.size -= pos;
+        if (!send_all(c)) return 0;
+    }
+    
+    return 1;
+}
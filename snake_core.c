@@ -0,0 +1,528 @@
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "snake_core.h"
+
+void occupy_cell(GameState *g, Cell c);
+void release_cell(GameState *g, Cell c);
+void mark_dirty(GameState *g, Cell c);
+void clear_board(GameState *g);
+void reset_board(GameState *g);
+int select_bit(uint64_t word, int k);
+Cell pick_free_cell(GameState *g);
+int grow_body(GameState *g);
+uint64_t splitmix64(uint64_t *x);
+
+int create_board(Board *b, int width, int height) {
+    memset(b, 0, sizeof(*b));
+    if (width < MIN_BOARD_SIDE || width > MAX_BOARD_SIDE || height < MIN_BOARD_SIDE || height > MAX_BOARD_SIDE) {
+        return 0;
+    }
+    
+    b->width = width;
+    b->height = height;
+    b->cells = width * height;
+    b->words = (b->cells + 63) / 64;
+    b->blocks = (b->cells + (1 << BLOCK_SHIFT) - 1) >> BLOCK_SHIFT;
+    
+    if (b->cells <= NEIGHBOR_TABLE_CELLS) {
+        b->neighbor = malloc(sizeof(Cell) * 4 * (size_t)b->cells);
+        if (!b->neighbor) return 0;
+        
+        for (Cell c = 0; c < (Cell)b->cells; c++) {
+            for (int d = UP; d <= RIGHT; d++) {
+                b->neighbor[(size_t)c * 4 + d] = wrap_cell(b, c, (Direction)d);
+            }
+        }
+    }
+    
+    return 1;
+}
+
+void free_board(Board *b) {
+    free(b->neighbor);
+    memset(b, 0, sizeof(*b));
+}
+
+void *alloc_aligned(size_t size) {
+    size = (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+#if defined(_WIN32)
+    return _aligned_malloc(size, CACHE_LINE);
+#else
+    return aligned_alloc(CACHE_LINE, size);
+#endif
+}
+
+void free_aligned(void *p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+uint64_t splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+void rng_seed(Rng *r, uint64_t seed) {
+    r->state = splitmix64(&seed);
+    if (r->state == 0) {
+        r->state = 0x9E3779B97F4A7C15ULL;
+    }
+}
+
+uint32_t rng_next(Rng *r) {
+    uint64_t x = r->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    r->state = x;
+    return (uint32_t)((x * 0x2545F4914F6CDD1DULL) >> 32);
+}
+
+uint32_t rng_bounded(Rng *r, uint32_t bound) {
+    uint64_t m = (uint64_t)rng_next(r) * bound;
+    uint32_t low = (uint32_t)m;
+    
+    if (low < bound) {
+        uint32_t threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            m = (uint64_t)rng_next(r) * bound;
+            low = (uint32_t)m;
+        }
+    }
+    
+    return (uint32_t)(m >> 32);
+}
+
+int create_game(GameState *g, const Board *board, uint64_t *bits) {
+    memset(g, 0, sizeof(*g));
+    g->board = board;
+    g->snake_mask = INITIAL_CAPACITY - 1;
+    g->snake = malloc(sizeof(Cell) * INITIAL_CAPACITY);
+    g->block_free = malloc(sizeof(uint32_t) * (size_t)board->blocks);
+    g->body_bits = bits;
+    
+    if (!bits) {
+        g->body_bits = alloc_aligned(sizeof(uint64_t) * (size_t)board->words);
+        g->owns_bits = 1;
+    }
+    
+    if (!g->snake || !g->block_free || !g->body_bits) {
+        free_game(g);
+        return 0;
+    }
+    
+    return 1;
+}
+
+void free_game(GameState *g) {
+    free(g->snake);
+    free(g->block_free);
+    if (g->owns_bits) {
+        free_aligned(g->body_bits);
+    }
+    memset(g, 0, sizeof(*g));
+}
+
+Cell segment(GameState *g, int i) {
+    return g->snake[(g->snake_head - i) & g->snake_mask];
+}
+
+Cell tail_cell(GameState *g) {
+    return g->snake[g->snake_tail];
+}
+
+void mark_dirty(GameState *g, Cell c) {
+    if (g->dirty_count == MAX_DIRTY) {
+        g->full_redraw = 1;
+        return;
+    }
+    
+    g->dirty_cells[g->dirty_count++] = c;
+}
+
+void occupy_cell(GameState *g, Cell c) {
+    g->body_bits[c >> 6] |= 1ULL << (c & 63);
+    g->block_free[c >> BLOCK_SHIFT]--;
+    g->free_count--;
+    mark_dirty(g, c);
+}
+
+void release_cell(GameState *g, Cell c) {
+    g->body_bits[c >> 6] &= ~(1ULL << (c & 63));
+    g->block_free[c >> BLOCK_SHIFT]++;
+    g->free_count++;
+    mark_dirty(g, c);
+}
+
+void clear_board(GameState *g) {
+    const Board *b = g->board;
+    
+    memset(g->body_bits, 0, sizeof(uint64_t) * (size_t)b->words);
+    for (int cell = b->cells; cell < b->words * 64; cell++) {
+        g->body_bits[cell >> 6] |= 1ULL << (cell & 63);
+    }
+    
+    for (int i = 0; i < b->blocks; i++) {
+        int first = i << BLOCK_SHIFT;
+        int last = first + (1 << BLOCK_SHIFT);
+        g->block_free[i] = (uint32_t)((last < b->cells ? last : b->cells) - first);
+    }
+    g->free_count = b->cells;
+    g->board_ready = 1;
+}
+
+void reset_board(GameState *g) {
+    if (!g->board_ready || g->snake_length >= g->board->words) {
+        clear_board(g);
+        return;
+    }
+    
+    for (int i = 0; i < g->snake_length; i++) {
+        Cell c = g->snake[(g->snake_tail + i) & g->snake_mask];
+        g->body_bits[c >> 6] &= ~(1ULL << (c & 63));
+        g->block_free[c >> BLOCK_SHIFT]++;
+    }
+    g->free_count = g->board->cells;
+}
+
+int select_bit(uint64_t word, int k) {
+#if defined(__BMI2__)
+    return CTZ64(_pdep_u64(1ULL << k, word));
+#else
+    while (k-- > 0) {
+        word &= word - 1;
+    }
+    return CTZ64(word);
+#endif
+}
+
+Cell pick_free_cell(GameState *g) {
+    int k = (int)rng_bounded(&g->rng, g->free_count);
+    int block = 0;
+    
+    while (k >= (int)g->block_free[block]) {
+        k -= (int)g->block_free[block++];
+    }
+    
+    for (int w = block << (BLOCK_SHIFT - 6); w < g->board->words; w++) {
+        uint64_t free_bits = ~g->body_bits[w];
+        int count = POPCOUNT64(free_bits);
+        
+        if (k < count) {
+            return (Cell)(w * 64 + select_bit(free_bits, k));
+        }
+        k -= count;
+    }
+    
+    return 0;
+}
+
+int grow_body(GameState *g) {
+    int capacity = g->snake_mask + 1;
+    Cell *snake = malloc(sizeof(Cell) * (size_t)capacity * 2);
+    if (!snake) return 0;
+    
+    int first = capacity - g->snake_tail;
+    memcpy(snake, &g->snake[g->snake_tail], sizeof(Cell) * (size_t)first);
+    memcpy(&snake[first], g->snake, sizeof(Cell) * (size_t)g->snake_tail);
+    
+    free(g->snake);
+    g->snake = snake;
+    g->snake_mask = capacity * 2 - 1;
+    g->snake_tail = 0;
+    g->snake_head = g->snake_length - 1;
+    return 1;
+}
+
+int can_grow(GameState *g) {
+    return g->snake_length <= g->snake_mask;
+}
+
+void init_game(GameState *g, uint64_t seed) {
+    const Board *b = g->board;
+    
+    reset_board(g);
+    g->seed = seed;
+    rng_seed(&g->rng, seed);
+    g->snake_length = START_LENGTH;
+    g->snake_head = g->snake_length - 1;
+    g->snake_tail = 0;
+    g->current_dir = RIGHT;
+    g->turn_head = 0;
+    g->turn_count = 0;
+    g->score = 0;
+    g->speed = START_SPEED;
+    g->paused = 0;
+    g->status = GAME_RUNNING;
+    g->dirty_count = 0;
+    g->full_redraw = 1;
+    
+    for (int i = 0; i < g->snake_length; i++) {
+        g->snake[g->snake_head - i] = cell_at(b, b->width / 2 - i, b->height / 2);
+        occupy_cell(g, segment(g, i));
+    }
+    
+    spawn_food(g);
+}
+
+void spawn_food(GameState *g) {
+    if (g->free_count == 0) {
+        g->status = GAME_WON;
+        return;
+    }
+    
+    g->food = pick_free_cell(g);
+    mark_dirty(g, g->food);
+}
+
+int is_reverse(Direction a, Direction b) {
+    return (a == UP && b == DOWN) || (a == DOWN && b == UP) ||
+           (a == LEFT && b == RIGHT) || (a == RIGHT && b == LEFT);
+}
+
+void queue_turn(GameState *g, Direction dir) {
+    Direction last = (Direction)g->current_dir;
+    if (g->turn_count > 0) {
+        last = (Direction)g->turn_queue[(g->turn_head + g->turn_count - 1) % TURN_QUEUE_SIZE];
+    }
+    
+    if (g->turn_count == TURN_QUEUE_SIZE || dir == last || is_reverse(dir, last)) {
+        return;
+    }
+    
+    g->turn_queue[(g->turn_head + g->turn_count) % TURN_QUEUE_SIZE] = dir;
+    g->turn_count++;
+}
+
+int check_collision(GameState *g, Cell c, int grow) {
+    int leaving_tail = !grow && c == g->snake[g->snake_tail];
+    
+    return cell_occupied(g, c) && !leaving_tail;
+}
+
+void move_snake(GameState *g) {
+    if (g->paused || g->status != GAME_RUNNING) return;
+    
+    if (g->turn_count > 0) {
+        g->current_dir = g->turn_queue[g->turn_head];
+        g->turn_head = (g->turn_head + 1) % TURN_QUEUE_SIZE;
+        g->turn_count--;
+    }
+    
+    Cell new_head = next_cell(g->board, segment(g, 0), (Direction)g->current_dir);
+    int ate = new_head == g->food;
+    int grow = ate && can_grow(g);
+    
+    apply_move(g, new_head, ate, check_collision(g, new_head, grow));
+}
+
+void apply_move(GameState *g, Cell new_head, int ate, int hit) {
+    int grow = ate && can_grow(g);
+    
+    if (hit) {
+        g->status = GAME_OVER;
+        return;
+    }
+    
+    mark_dirty(g, segment(g, 0));
+    
+    if (grow) {
+        g->snake_length++;
+    }
+    else {
+        release_cell(g, g->snake[g->snake_tail]);
+        g->snake_tail = (g->snake_tail + 1) & g->snake_mask;
+    }
+    
+    g->snake_head = (g->snake_head + 1) & g->snake_mask;
+    g->snake[g->snake_head] = new_head;
+    occupy_cell(g, new_head);
+    
+    if (g->snake_length > g->snake_mask && g->snake_length < g->board->cells) {
+        grow_body(g);
+    }
+    
+    if (ate) {
+        if (grow) {
+            g->score += 10;
+            
+            if (g->speed > MIN_SPEED) {
+                g->speed -= 2;
+            }
+        }
+        spawn_food(g);
+    }
+}
+
+size_t snapshot_size(const GameState *g) {
+    const Board *b = g->board;
+    
+    return sizeof(Snapshot) + sizeof(uint64_t) * (size_t)b->words + sizeof(uint32_t) * (size_t)b->blocks +
+           sizeof(Cell) * (size_t)g->snake_length;
+}
+
+size_t snapshot_capacity(const Board *b) {
+    return sizeof(Snapshot) + sizeof(uint64_t) * (size_t)b->words + sizeof(uint32_t) * (size_t)b->blocks +
+           sizeof(Cell) * (size_t)b->cells;
+}
+
+size_t snapshot(const GameState *g, void *buffer) {
+    const Board *b = g->board;
+    Snapshot *s = buffer;
+    uint64_t *bits = (uint64_t *)(s + 1);
+    uint32_t *block_free = (uint32_t *)(bits + b->words);
+    Cell *body = (Cell *)(block_free + b->blocks);
+    int first = g->snake_mask + 1 - g->snake_tail;
+    
+    s->rng = g->rng;
+    s->seed = g->seed;
+    s->width = b->width;
+    s->height = b->height;
+    s->snake_length = g->snake_length;
+    s->score = g->score;
+    s->speed = g->speed;
+    s->food = g->food;
+    s->current_dir = g->current_dir;
+    s->turn_head = g->turn_head;
+    s->turn_count = g->turn_count;
+    s->paused = g->paused;
+    s->status = g->status;
+    memcpy(s->turn_queue, g->turn_queue, sizeof(s->turn_queue));
+    
+    memcpy(bits, g->body_bits, sizeof(uint64_t) * (size_t)b->words);
+    memcpy(block_free, g->block_free, sizeof(uint32_t) * (size_t)b->blocks);
+    if (first >= g->snake_length) {
+        memcpy(body, &g->snake[g->snake_tail], sizeof(Cell) * (size_t)g->snake_length);
+    }
+    else {
+        memcpy(body, &g->snake[g->snake_tail], sizeof(Cell) * (size_t)first);
+        memcpy(&body[first], g->snake, sizeof(Cell) * (size_t)(g->snake_length - first));
+    }
+    
+    return snapshot_size(g);
+}
+
+int restore(GameState *g, const void *buffer) {
+    const Board *b = g->board;
+    const Snapshot *s = buffer;
+    const uint64_t *bits = (const uint64_t *)(s + 1);
+    const uint32_t *block_free = (const uint32_t *)(bits + b->words);
+    const Cell *body = (const Cell *)(block_free + b->blocks);
+    
+    if (s->width != b->width || s->height != b->height) {
+        return 0;
+    }
+    
+    g->snake_length = 0;
+    while (g->snake_mask < s->snake_length) {
+        if (!grow_body(g)) return 0;
+    }
+    
+    g->rng = s->rng;
+    g->seed = s->seed;
+    g->snake_length = s->snake_length;
+    g->snake_tail = 0;
+    g->snake_head = s->snake_length - 1;
+    g->free_count = b->cells - s->snake_length;
+    g->score = s->score;
+    g->speed = s->speed;
+    g->food = s->food;
+    g->current_dir = s->current_dir;
+    g->turn_head = s->turn_head;
+    g->turn_count = s->turn_count;
+    g->paused = s->paused;
+    g->status = s->status;
+    memcpy(g->turn_queue, s->turn_queue, sizeof(g->turn_queue));
+    g->dirty_count = 0;
+    g->full_redraw = 1;
+    
+    memcpy(g->body_bits, bits, sizeof(uint64_t) * (size_t)b->words);
+    memcpy(g->block_free, block_free, sizeof(uint32_t) * (size_t)b->blocks);
+    memcpy(g->snake, body, sizeof(Cell) * (size_t)s->snake_length);
+    g->board_ready = 1;
+    return 1;
+}
+
+GameStatus step_undoable(GameState *g, int action, StepUndo *u) {
+    int length = g->snake_length;
+    int live = g->status == GAME_RUNNING && !g->paused;
+    
+    u->rng = g->rng;
+    u->food = g->food;
+    u->tail = g->snake[g->snake_tail];
+    u->score = g->score;
+    u->speed = g->speed;
+    u->dirty_count = g->dirty_count;
+    u->current_dir = g->current_dir;
+    u->turn_head = g->turn_head;
+    u->turn_count = g->turn_count;
+    u->status = g->status;
+    u->full_redraw = g->full_redraw;
+    memcpy(u->turn_queue, g->turn_queue, sizeof(u->turn_queue));
+    
+    step(g, action);
+    
+    u->moved = live && g->status != GAME_OVER;
+    u->grew = g->snake_length > length;
+    return (GameStatus)g->status;
+}
+
+void undo_step(GameState *g, const StepUndo *u) {
+    if (u->moved) {
+        Cell head = g->snake[g->snake_head];
+        g->snake_head = (g->snake_head - 1) & g->snake_mask;
+        release_cell(g, head);
+        
+        if (u->grew) {
+            g->snake_length--;
+        }
+        else {
+            g->snake_tail = (g->snake_tail - 1) & g->snake_mask;
+            g->snake[g->snake_tail] = u->tail;
+            occupy_cell(g, u->tail);
+        }
+    }
+    
+    g->rng = u->rng;
+    g->food = u->food;
+    g->score = u->score;
+    g->speed = u->speed;
+    g->dirty_count = u->dirty_count;
+    g->current_dir = u->current_dir;
+    g->turn_head = u->turn_head;
+    g->turn_count = u->turn_count;
+    g->status = u->status;
+    g->full_redraw = u->full_redraw;
+    memcpy(g->turn_queue, u->turn_queue, sizeof(g->turn_queue));
+}
+
+GameStatus step(GameState *g, int action) {
+    if (action != ACTION_NONE) {
+        queue_turn(g, (Direction)action);
+    }
+    
+    move_snake(g);
+    return (GameStatus)g->status;
+}
+
+int tick_period_ms(GameState *g) {
+    if (g->current_dir == UP || g->current_dir == DOWN) {
+        return (int)(g->speed * 1.8);
+    }
+    
+    return g->speed;
+}
\ No newline at end of file
@@ -0,0 +1,205 @@
+#ifndef SNAKE_CORE_H
+#define SNAKE_CORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DEFAULT_WIDTH 30
+#define DEFAULT_HEIGHT 15
+#define MIN_BOARD_SIDE 4
+#define MAX_BOARD_SIDE 4096
+#define NEIGHBOR_TABLE_CELLS 65536
+#define BLOCK_SHIFT 12
+#define INITIAL_CAPACITY 64
+#define MAX_DIRTY 16
+#define TURN_QUEUE_SIZE 4
+#define START_LENGTH 3
+#define START_SPEED 100
+#define MIN_SPEED 50
+#define ACTION_NONE -1
+#define CACHE_LINE 64
+
+#if defined(_MSC_VER)
+#define CACHE_ALIGN __declspec(align(CACHE_LINE))
+#else
+#define CACHE_ALIGN __attribute__((aligned(CACHE_LINE)))
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define POPCOUNT64(x) ((int)__popcnt64(x))
+#define CTZ64(x) ctz64(x)
+
+static inline int ctz64(uint64_t x) {
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+}
+#else
+#define POPCOUNT64(x) __builtin_popcountll(x)
+#define CTZ64(x) __builtin_ctzll(x)
+#endif
+
+typedef uint32_t Cell;
+
+typedef enum {
+    UP,
+    DOWN,
+    LEFT,
+    RIGHT
+} Direction;
+
+typedef struct {
+    uint64_t state;
+} Rng;
+
+typedef enum {
+    GAME_RUNNING,
+    GAME_OVER,
+    GAME_WON
+} GameStatus;
+
+typedef struct {
+    int width;
+    int height;
+    int cells;
+    int words;
+    int blocks;
+    Cell *neighbor;
+} Board;
+
+typedef struct {
+    Cell food;
+    int snake_head;
+    int snake_tail;
+    int snake_length;
+    int snake_mask;
+    int free_count;
+    int score;
+    int speed;
+    int dirty_count;
+    unsigned char current_dir;
+    unsigned char turn_head;
+    unsigned char turn_count;
+    unsigned char paused;
+    unsigned char status;
+    unsigned char full_redraw;
+    unsigned char turn_queue[TURN_QUEUE_SIZE];
+    Rng rng;
+    Cell *snake;
+    uint64_t *body_bits;
+    const Board *board;
+    
+    CACHE_ALIGN Cell dirty_cells[MAX_DIRTY];
+    uint32_t *block_free;
+    int owns_bits;
+    int board_ready;
+    uint64_t seed;
+} GameState;
+
+_Static_assert(offsetof(GameState, turn_queue) + TURN_QUEUE_SIZE <= CACHE_LINE && offsetof(GameState, dirty_count) < CACHE_LINE,
+               "per-tick GameState fields must share the first cache line");
+
+typedef struct {
+    Rng rng;
+    uint64_t seed;
+    int width;
+    int height;
+    int snake_length;
+    int score;
+    int speed;
+    Cell food;
+    unsigned char current_dir;
+    unsigned char turn_head;
+    unsigned char turn_count;
+    unsigned char paused;
+    unsigned char status;
+    unsigned char turn_queue[TURN_QUEUE_SIZE];
+} Snapshot;
+
+typedef struct {
+    Rng rng;
+    Cell food;
+    Cell tail;
+    int score;
+    int speed;
+    int dirty_count;
+    unsigned char current_dir;
+    unsigned char turn_head;
+    unsigned char turn_count;
+    unsigned char status;
+    unsigned char full_redraw;
+    unsigned char moved;
+    unsigned char grew;
+    unsigned char turn_queue[TURN_QUEUE_SIZE];
+} StepUndo;
+
+static inline Cell cell_at(const Board *b, int x, int y) {
+    return (Cell)y * (Cell)b->width + (Cell)x;
+}
+
+static inline int cell_x(const Board *b, Cell c) {
+    return (int)(c % (Cell)b->width);
+}
+
+static inline int cell_y(const Board *b, Cell c) {
+    return (int)(c / (Cell)b->width);
+}
+
+static inline Cell wrap_cell(const Board *b, Cell c, Direction dir) {
+    Cell width = (Cell)b->width;
+    Cell cells = (Cell)b->cells;
+    
+    switch (dir) {
+        case UP:
+            return c >= width ? c - width : c + cells - width;
+        case DOWN:
+            return c + width < cells ? c + width : c + width - cells;
+        case LEFT:
+            return c % width != 0 ? c - 1 : c + width - 1;
+        default:
+            return c % width != width - 1 ? c + 1 : c + 1 - width;
+    }
+}
+
+static inline Cell next_cell(const Board *b, Cell c, Direction dir) {
+    if (b->neighbor) {
+        return b->neighbor[(size_t)c * 4 + dir];
+    }
+    
+    return wrap_cell(b, c, dir);
+}
+
+static inline int cell_occupied(const GameState *g, Cell c) {
+    return (int)((g->body_bits[c >> 6] >> (c & 63)) & 1);
+}
+
+int create_board(Board *b, int width, int height);
+void free_board(Board *b);
+void *alloc_aligned(size_t size);
+void free_aligned(void *p);
+void rng_seed(Rng *r, uint64_t seed);
+uint32_t rng_next(Rng *r);
+uint32_t rng_bounded(Rng *r, uint32_t bound);
+int create_game(GameState *g, const Board *board, uint64_t *bits);
+void free_game(GameState *g);
+void init_game(GameState *g, uint64_t seed);
+GameStatus step(GameState *g, int action);
+void queue_turn(GameState *g, Direction dir);
+void move_snake(GameState *g);
+void apply_move(GameState *g, Cell new_head, int ate, int hit);
+void spawn_food(GameState *g);
+int check_collision(GameState *g, Cell c, int grow);
+Cell segment(GameState *g, int i);
+Cell tail_cell(GameState *g);
+int can_grow(GameState *g);
+size_t snapshot_size(const GameState *g);
+size_t snapshot_capacity(const Board *b);
+size_t snapshot(const GameState *g, void *buffer);
+int restore(GameState *g, const void *buffer);
+GameStatus step_undoable(GameState *g, int action, StepUndo *u);
+void undo_step(GameState *g, const StepUndo *u);
+int is_reverse(Direction a, Direction b);
+int tick_period_ms(GameState *g);
+
+#endif
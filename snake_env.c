@@ -0,0 +1,256 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_batch.h"
+#include "snake_env.h"
+
+struct SnakeEnv {
+    Board board;
+    GameBatch batch;
+    Rng rng;
+    int kind;
+    void *observations;
+    int starve_limit;
+    int32_t *idle;
+    int32_t *score;
+    int32_t *last_score;
+    Cell *shown_head;
+    Cell *shown_food;
+};
+
+uint64_t next_seed(SnakeEnv *e);
+void reset_env_game(SnakeEnv *e, int i);
+void write_planes(SnakeEnv *e, int i);
+void update_planes(SnakeEnv *e, int i);
+void write_features(SnakeEnv *e, int i);
+void write_observation(SnakeEnv *e, int i);
+float wrap_offset(int from, int to, int size);
+
+int env_version(void) {
+    return ENV_API_VERSION;
+}
+
+SnakeEnv *env_create(int count, int width, int height, uint64_t seed) {
+    if (count <= 0) return NULL;
+    
+    SnakeEnv *e = calloc(1, sizeof(SnakeEnv));
+    if (!e) return NULL;
+    
+    if (!create_board(&e->board, width, height)) {
+        free(e);
+        return NULL;
+    }
+    
+    e->idle = calloc((size_t)count, sizeof(int32_t));
+    e->score = calloc((size_t)count, sizeof(int32_t));
+    e->last_score = calloc((size_t)count, sizeof(int32_t));
+    e->shown_head = calloc((size_t)count, sizeof(Cell));
+    e->shown_food = calloc((size_t)count, sizeof(Cell));
+    if (!e->idle || !e->score || !e->last_score || !e->shown_head || !e->shown_food || !init_batch(&e->batch, &e->board, count, seed)) {
+        env_free(e);
+        return NULL;
+    }
+    
+    e->starve_limit = e->board.cells;
+    rng_seed(&e->rng, seed);
+    env_reset(e, NULL);
+    return e;
+}
+
+void env_free(SnakeEnv *e) {
+    if (!e) return;
+    
+    free_batch(&e->batch);
+    free_board(&e->board);
+    free(e->idle);
+    free(e->score);
+    free(e->last_score);
+    free(e->shown_head);
+    free(e->shown_food);
+    free(e);
+}
+
+int env_count(const SnakeEnv *e) {
+    return e->batch.count;
+}
+
+size_t env_observation_size(const SnakeEnv *e, int kind) {
+    switch (kind) {
+        case ENV_OBS_PLANES:
+            return (size_t)ENV_PLANES * (size_t)e->board.cells;
+        case ENV_OBS_FEATURES:
+            return sizeof(float) * ENV_FEATURES;
+        default:
+            return 0;
+    }
+}
+
+int env_bind_observations(SnakeEnv *e, int kind, void *buffer) {
+    if (kind != ENV_OBS_NONE && kind != ENV_OBS_PLANES && kind != ENV_OBS_FEATURES) return 0;
+    if (kind != ENV_OBS_NONE && !buffer) return 0;
+    
+    e->kind = buffer ? kind : ENV_OBS_NONE;
+    e->observations = buffer;
+    for (int i = 0; i < e->batch.count; i++) {
+        e->batch.games[i].full_redraw = 1;
+        write_observation(e, i);
+    }
+    return 1;
+}
+
+void env_reset(SnakeEnv *e, const uint8_t *mask) {
+    for (int i = 0; i < e->batch.count; i++) {
+        if (!mask || mask[i]) {
+            reset_env_game(e, i);
+            write_observation(e, i);
+        }
+    }
+}
+
+int env_step(SnakeEnv *e, const int32_t *actions, float *rewards, uint8_t *dones) {
+    GameBatch *b = &e->batch;
+    int finished = 0;
+    
+    for (int i = 0; i < b->count; i++) {
+        e->score[i] = b->games[i].score;
+    }
+    
+    step_batch(b, (const int *)actions);
+    
+    for (int i = 0; i < b->count; i++) {
+        GameState *g = &b->games[i];
+        float reward = 0.0f;
+        int done = ENV_RUNNING;
+        
+        if (g->score > e->score[i]) {
+            reward += ENV_REWARD_FOOD;
+            e->idle[i] = 0;
+        }
+        else {
+            e->idle[i]++;
+        }
+        
+        if (g->status == GAME_OVER) {
+            reward += ENV_REWARD_DEATH;
+            done = ENV_TERMINATED;
+        }
+        else if (g->status == GAME_WON) {
+            reward += ENV_REWARD_WIN;
+            done = ENV_TERMINATED;
+        }
+        else if (e->idle[i] >= e->starve_limit) {
+            done = ENV_TRUNCATED;
+        }
+        
+        if (done != ENV_RUNNING) {
+            e->last_score[i] = g->score;
+            reset_env_game(e, i);
+            finished++;
+        }
+        
+        write_observation(e, i);
+        if (rewards) rewards[i] = reward;
+        if (dones) dones[i] = (uint8_t)done;
+    }
+    
+    return finished;
+}
+
+int32_t env_last_score(const SnakeEnv *e, int index) {
+    return index >= 0 && index < e->batch.count ? e->last_score[index] : 0;
+}
+
+uint64_t next_seed(SnakeEnv *e) {
+    uint64_t high = rng_next(&e->rng);
+    return high << 32 | rng_next(&e->rng);
+}
+
+void reset_env_game(SnakeEnv *e, int i) {
+    reset_batch_game(&e->batch, i, next_seed(e));
+    e->idle[i] = 0;
+}
+
+void write_planes(SnakeEnv *e, int i) {
+    GameState *g = &e->batch.games[i];
+    size_t cells = (size_t)e->board.cells;
+    uint8_t *obs = (uint8_t *)e->observations + (size_t)i * ENV_PLANES * cells;
+    
+    memset(obs, 0, ENV_PLANES * cells);
+    for (int w = 0; w < e->board.words; w++) {
+        uint64_t bits = g->body_bits[w];
+        if (w == e->board.words - 1 && cells % 64 != 0) {
+            bits &= (1ULL << (cells % 64)) - 1;
+        }
+        while (bits) {
+            obs[(size_t)w * 64 + (size_t)CTZ64(bits)] = 1;
+            bits &= bits - 1;
+        }
+    }
+    
+    e->shown_head[i] = segment(g, 0);
+    e->shown_food[i] = g->food;
+    obs[cells + e->shown_head[i]] = 1;
+    obs[2 * cells + e->shown_food[i]] = 1;
+}
+
+void update_planes(SnakeEnv *e, int i) {
+    GameState *g = &e->batch.games[i];
+    size_t cells = (size_t)e->board.cells;
+    uint8_t *obs = (uint8_t *)e->observations + (size_t)i * ENV_PLANES * cells;
+    
+    if (g->full_redraw) {
+        write_planes(e, i);
+        return;
+    }
+    
+    for (int d = 0; d < g->dirty_count; d++) {
+        Cell c = g->dirty_cells[d];
+        obs[c] = (uint8_t)cell_occupied(g, c);
+    }
+    
+    obs[cells + e->shown_head[i]] = 0;
+    obs[2 * cells + e->shown_food[i]] = 0;
+    e->shown_head[i] = segment(g, 0);
+    e->shown_food[i] = g->food;
+    obs[cells + e->shown_head[i]] = 1;
+    obs[2 * cells + e->shown_food[i]] = 1;
+}
+
+float wrap_offset(int from, int to, int size) {
+    int offset = (to - from + size) % size;
+    if (offset > size / 2) offset -= size;
+    
+    return (float)offset / (float)(size / 2);
+}
+
+void write_features(SnakeEnv *e, int i) {
+    GameState *g = &e->batch.games[i];
+    const Board *b = &e->board;
+    float *obs = (float *)e->observations + (size_t)i * ENV_FEATURES;
+    Cell head = segment(g, 0);
+    
+    for (int d = UP; d <= RIGHT; d++) {
+        Cell next = next_cell(b, head, (Direction)d);
+        int grow = next == g->food && can_grow(g);
+        obs[d] = (float)check_collision(g, next, grow);
+        obs[6 + d] = (float)(g->current_dir == d);
+    }
+    
+    obs[4] = wrap_offset(cell_x(b, head), cell_x(b, g->food), b->width);
+    obs[5] = wrap_offset(cell_y(b, head), cell_y(b, g->food), b->height);
+    obs[10] = (float)g->snake_length / (float)b->cells;
+}
+
+void write_observation(SnakeEnv *e, int i) {
+    GameState *g = &e->batch.games[i];
+    
+    if (e->kind == ENV_OBS_PLANES) {
+        update_planes(e, i);
+    }
+    else if (e->kind == ENV_OBS_FEATURES) {
+        write_features(e, i);
+    }
+    
+    g->dirty_count = 0;
+    g->full_redraw = 0;
+}
@@ -0,0 +1,38 @@
+#ifndef SNAKE_ENV_H
+#define SNAKE_ENV_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ENV_API_VERSION 1
+#define ENV_PLANES 3
+#define ENV_FEATURES 11
+#define ENV_REWARD_FOOD 1.0f
+#define ENV_REWARD_DEATH -1.0f
+#define ENV_REWARD_WIN 10.0f
+
+typedef enum {
+    ENV_OBS_NONE,
+    ENV_OBS_PLANES,
+    ENV_OBS_FEATURES
+} EnvObservation;
+
+typedef enum {
+    ENV_RUNNING,
+    ENV_TERMINATED,
+    ENV_TRUNCATED
+} EnvDone;
+
+typedef struct SnakeEnv SnakeEnv;
+
+int env_version(void);
+SnakeEnv *env_create(int count, int width, int height, uint64_t seed);
+void env_free(SnakeEnv *e);
+int env_count(const SnakeEnv *e);
+size_t env_observation_size(const SnakeEnv *e, int kind);
+int env_bind_observations(SnakeEnv *e, int kind, void *buffer);
+void env_reset(SnakeEnv *e, const uint8_t *mask);
+int env_step(SnakeEnv *e, const int32_t *actions, float *rewards, uint8_t *dones);
+int32_t env_last_score(const SnakeEnv *e, int index);
+
+#endif
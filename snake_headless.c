@@ -0,0 +1,650 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snake_core.h"
+#include "snake_archive.h"
+#include "snake_arena.h"
+#include "snake_autopilot.h"
+#include "snake_batch.h"
+#include "snake_pool.h"
+#include "snake_replay.h"
+#include "snake_stream.h"
+#include "snake_view.h"
+#include "snake_workers.h"
+
+#define DEFAULT_GAMES 1000
+#define DEFAULT_MAX_TICKS 100000
+#define DEFAULT_CHUNK 16
+
+typedef struct {
+    long games;
+    long long ticks;
+    long long score;
+    int best_score;
+    long wins;
+} Totals;
+
+typedef struct {
+    CACHE_ALIGN Totals totals;
+    GamePool pool;
+} WorkerTotals;
+
+typedef struct {
+    const Board *board;
+    long games;
+    long max_ticks;
+    uint64_t seed;
+    int batch;
+    long chunk;
+    int autopilot;
+    AutopilotMode mode;
+    WorkerTotals *workers;
+} RunPlan;
+
+int wrap_distance(int a, int b, int size);
+int food_distance(GameState *g, Cell c);
+int choose_action(GameState *g);
+int next_action(Autopilot *a, GameState *g);
+void record_game(Totals *t, GameState *g, long ticks);
+void merge_totals(Totals *into, Totals *from);
+void run_scalar(Totals *t, GamePool *pool, RunPlan *plan, long first, long games);
+int run_batched(Totals *t, RunPlan *plan, long first, long games);
+void run_chunk(void *context, long task, int worker);
+int run_threaded(Totals *t, RunPlan *plan, int threads, long *steals);
+int record_first_game(RunPlan *plan, const char *path);
+int stream_first_game(RunPlan *plan, const char *path);
+int run_archived(Totals *t, RunPlan *plan, const char *path);
+int play_replay(const char *path, long target);
+int scan_archive(const char *path, long game);
+int run_arena(const Board *board, int snakes, int food, long ticks, uint64_t seed);
+double elapsed_seconds(struct timespec *start);
+
+int main(int argc, char *argv[]) {
+    long games = DEFAULT_GAMES;
+    long max_ticks = DEFAULT_MAX_TICKS;
+    uint64_t seed = (uint64_t)time(NULL);
+    int batch = 0;
+    int threads = -1;
+    long chunk = DEFAULT_CHUNK;
+    int width = DEFAULT_WIDTH;
+    int height = DEFAULT_HEIGHT;
+    int autopilot = 0;
+    AutopilotMode mode = AUTOPILOT_PATH;
+    const char *record_path = NULL;
+    const char *stream_path = NULL;
+    const char *replay_path = NULL;
+    const char *archive_path = NULL;
+    const char *scan_path = NULL;
+    long seek = -1;
+    long game = -1;
+    int arena = 0;
+    int food = -1;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--games") == 0 && i + 1 < argc) {
+            games = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            max_ticks = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc) {
+            batch = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--chunk") == 0 && i + 1 < argc) {
+            chunk = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--autopilot") == 0 && i + 1 < argc && parse_autopilot_mode(argv[i + 1], &mode)) {
+            autopilot = 1;
+            i++;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            stream_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            seek = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--archive") == 0 && i + 1 < argc) {
+            archive_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--scan") == 0 && i + 1 < argc) {
+            scan_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--game") == 0 && i + 1 < argc) {
+            game = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--arena") == 0 && i + 1 < argc) {
+            arena = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--food") == 0 && i + 1 < argc) {
+            food = atoi(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--games N] [--ticks N] [--seed N] [--batch N] [--threads N] [--chunk N] [--width N] [--height N] [--autopilot path|cycle] [--record FILE] [--stream FILE] [--replay FILE [--seek N]] [--archive FILE] [--scan FILE [--game N]] [--arena N [--food N]]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (replay_path) {
+        return play_replay(replay_path, seek) ? 0 : 1;
+    }
+    if (scan_path) {
+        return scan_archive(scan_path, game) ? 0 : 1;
+    }
+    
+    if (threads == 0) threads = hardware_threads();
+    if (chunk < 1) chunk = 1;
+    
+    Board board;
+    if (!create_board(&board, width, height)) {
+        fprintf(stderr, "board must be between %d and %d cells on each side\n", MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        return 1;
+    }
+    
+    if (arena > 0) {
+        int ok = run_arena(&board, arena, food < 0 ? arena : food, max_ticks, seed);
+        free_board(&board);
+        return ok ? 0 : 1;
+    }
+    
+    Totals totals = {0};
+    RunPlan plan = {&board, games, max_ticks, seed, batch, chunk, autopilot, mode, NULL};
+    long steals = 0;
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    
+    if (archive_path) {
+        threads = 0;
+        if (!run_archived(&totals, &plan, archive_path)) {
+            fprintf(stderr, "could not write archive %s\n", archive_path);
+            free_board(&board);
+            return 1;
+        }
+    }
+    else if (threads > 0) {
+        if (!run_threaded(&totals, &plan, threads, &steals)) {
+            fprintf(stderr, "could not start worker threads\n");
+            free_board(&board);
+            return 1;
+        }
+    }
+    else if (batch <= 0 || !run_batched(&totals, &plan, 0, games)) {
+        GamePool pool;
+        init_game_pool(&pool, &board, 1);
+        run_scalar(&totals, &pool, &plan, 0, games);
+        free_game_pool(&pool);
+    }
+    
+    double seconds = elapsed_seconds(&start);
+    if (record_path && !record_first_game(&plan, record_path)) {
+        fprintf(stderr, "could not write replay %s\n", record_path);
+    }
+    if (stream_path && !stream_first_game(&plan, stream_path)) {
+        fprintf(stderr, "could not write frame stream %s\n", stream_path);
+    }
+    free_board(&board);
+    
+    if (threads > 0) {
+        printf("threads:     %d\n", threads);
+        printf("steals:      %ld\n", steals);
+    }
+    printf("games:       %ld\n", totals.games);
+    printf("ticks:       %lld\n", totals.ticks);
+    printf("avg score:   %.1f\n", totals.games > 0 ? (double)totals.score / totals.games : 0.0);
+    printf("best score:  %d\n", totals.best_score);
+    printf("wins:        %ld\n", totals.wins);
+    printf("seconds:     %.3f\n", seconds);
+    printf("ticks/sec:   %.0f\n", seconds > 0 ? totals.ticks / seconds : 0.0);
+    return 0;
+}
+
+int wrap_distance(int a, int b, int size) {
+    int d = abs(a - b);
+    return d < size - d ? d : size - d;
+}
+
+int food_distance(GameState *g, Cell c) {
+    const Board *b = g->board;
+    return wrap_distance(cell_x(b, c), cell_x(b, g->food), b->width) + wrap_distance(cell_y(b, c), cell_y(b, g->food), b->height);
+}
+
+int choose_action(GameState *g) {
+    Cell head = segment(g, 0);
+    int best = ACTION_NONE;
+    int best_distance = g->board->cells;
+    
+    for (int d = UP; d <= RIGHT; d++) {
+        if (is_reverse((Direction)d, (Direction)g->current_dir)) continue;
+        
+        Cell c = next_cell(g->board, head, (Direction)d);
+        if (check_collision(g, c, c == g->food)) continue;
+        
+        int distance = food_distance(g, c);
+        if (distance < best_distance) {
+            best_distance = distance;
+            best = d;
+        }
+    }
+    
+    return best;
+}
+
+int next_action(Autopilot *a, GameState *g) {
+    return a ? autopilot_action(a, g) : choose_action(g);
+}
+
+void record_game(Totals *t, GameState *g, long ticks) {
+    t->games++;
+    t->ticks += ticks;
+    t->score += g->score;
+    if (g->score > t->best_score) t->best_score = g->score;
+    if (g->status == GAME_WON) t->wins++;
+}
+
+void merge_totals(Totals *into, Totals *from) {
+    into->games += from->games;
+    into->ticks += from->ticks;
+    into->score += from->score;
+    if (from->best_score > into->best_score) into->best_score = from->best_score;
+    into->wins += from->wins;
+}
+
+void run_scalar(Totals *t, GamePool *pool, RunPlan *plan, long first, long games) {
+    Autopilot autopilot;
+    Autopilot *a = plan->autopilot ? &autopilot : NULL;
+    GameState *game = acquire_game(pool);
+    if (!game) return;
+    if (a && !create_autopilot(a, plan->board, plan->mode)) {
+        release_game(pool, game);
+        return;
+    }
+    
+    for (long n = first; n < first + games; n++) {
+        init_game(game, plan->seed + n);
+        if (a) reset_autopilot(a);
+        
+        long ticks = 0;
+        while (ticks < plan->max_ticks && game->status == GAME_RUNNING) {
+            step(game, next_action(a, game));
+            ticks++;
+        }
+        
+        record_game(t, game, ticks);
+    }
+    
+    if (a) free_autopilot(a);
+    release_game(pool, game);
+}
+
+int run_batched(Totals *t, RunPlan *plan, long first, long games) {
+    GameBatch b;
+    uint64_t seed = plan->seed;
+    long max_ticks = plan->max_ticks;
+    int width = plan->batch;
+    if (width > games) width = (int)games;
+    if (width <= 0) return 1;
+    if (!init_batch(&b, plan->board, width, seed + first)) return 0;
+    
+    int *actions = malloc(sizeof(int) * width);
+    long *ticks = calloc(width, sizeof(long));
+    Autopilot *pilots = plan->autopilot ? calloc(width, sizeof(Autopilot)) : NULL;
+    int ok = actions && ticks && (pilots || !plan->autopilot);
+    for (int i = 0; ok && pilots && i < width; i++) {
+        ok = create_autopilot(&pilots[i], plan->board, plan->mode);
+    }
+    if (!ok) {
+        for (int i = 0; pilots && i < width; i++) {
+            free_autopilot(&pilots[i]);
+        }
+        free(pilots);
+        free(actions);
+        free(ticks);
+        free_batch(&b);
+        return 0;
+    }
+    
+    long next_game = first + width;
+    long end = first + games;
+    int active = width;
+    
+    while (active > 0) {
+        for (int i = 0; i < width; i++) {
+            actions[i] = b.status[i] == GAME_RUNNING ? next_action(pilots ? &pilots[i] : NULL, &b.games[i]) : ACTION_NONE;
+        }
+        
+        step_batch(&b, actions);
+        
+        for (int i = 0; i < width; i++) {
+            if (ticks[i] < 0) continue;
+            
+            ticks[i]++;
+            if (b.status[i] == GAME_RUNNING && ticks[i] < max_ticks) continue;
+            
+            record_game(t, &b.games[i], ticks[i]);
+            if (next_game < end) {
+                reset_batch_game(&b, i, seed + next_game++);
+                if (pilots) reset_autopilot(&pilots[i]);
+                ticks[i] = 0;
+            }
+            else {
+                b.status[i] = GAME_OVER;
+                ticks[i] = -1;
+                active--;
+            }
+        }
+    }
+    
+    for (int i = 0; pilots && i < width; i++) {
+        free_autopilot(&pilots[i]);
+    }
+    free(pilots);
+    free(actions);
+    free(ticks);
+    free_batch(&b);
+    return 1;
+}
+
+void run_chunk(void *context, long task, int worker) {
+    RunPlan *plan = context;
+    Totals *t = &plan->workers[worker].totals;
+    long first = task * plan->chunk;
+    long games = plan->games - first < plan->chunk ? plan->games - first : plan->chunk;
+    
+    if (plan->batch <= 0 || !run_batched(t, plan, first, games)) {
+        run_scalar(t, &plan->workers[worker].pool, plan, first, games);
+    }
+}
+
+int run_threaded(Totals *t, RunPlan *plan, int threads, long *steals) {
+    long tasks = (plan->games + plan->chunk - 1) / plan->chunk;
+    WorkerStats *stats = calloc(threads, sizeof(WorkerStats));
+    plan->workers = alloc_aligned(sizeof(WorkerTotals) * (size_t)threads);
+    
+    int ok = stats && plan->workers;
+    if (ok) {
+        memset(plan->workers, 0, sizeof(WorkerTotals) * (size_t)threads);
+        for (int i = 0; i < threads; i++) {
+            init_game_pool(&plan->workers[i].pool, plan->board, 1);
+        }
+        ok = run_work_stealing(threads, tasks, run_chunk, plan, stats);
+    }
+    
+    for (int i = 0; ok && i < threads; i++) {
+        merge_totals(t, &plan->workers[i].totals);
+        *steals += stats[i].steals;
+    }
+    for (int i = 0; plan->workers && i < threads; i++) {
+        free_game_pool(&plan->workers[i].pool);
+    }
+    
+    free(stats);
+    free_aligned(plan->workers);
+    plan->workers = NULL;
+    return ok;
+}
+
+int record_first_game(RunPlan *plan, const char *path) {
+    GameState game;
+    Autopilot autopilot;
+    Autopilot *a = plan->autopilot ? &autopilot : NULL;
+    ReplayWriter w;
+    if (!create_game(&game, plan->board, NULL)) return 0;
+    if (a && !create_autopilot(a, plan->board, plan->mode)) {
+        free_game(&game);
+        return 0;
+    }
+    
+    init_game(&game, plan->seed);
+    if (a) reset_autopilot(a);
+    
+    int ok = begin_recording(&w, &game);
+    for (long ticks = 0; ok && ticks < plan->max_ticks && game.status == GAME_RUNNING; ticks++) {
+        step(&game, next_action(a, &game));
+        ok = record_tick(&w, &game);
+    }
+    
+    ok = ok && save_replay(&w, path);
+    free_recording(&w);
+    if (a) free_autopilot(a);
+    free_game(&game);
+    return ok;
+}
+
+int stream_first_game(RunPlan *plan, const char *path) {
+    GameState game;
+    Autopilot autopilot;
+    Autopilot *a = plan->autopilot ? &autopilot : NULL;
+    View view;
+    StreamWriter stream = {0};
+    const Board *b = plan->board;
+    FILE *file = fopen(path, "wb");
+    if (!file) return 0;
+    
+    int ok = create_game(&game, b, NULL);
+    if (ok && a && !create_autopilot(a, b, plan->mode)) {
+        free_game(&game);
+        ok = 0;
+    }
+    if (!ok) {
+        fclose(file);
+        return 0;
+    }
+    
+    ok = create_view(&view, b, b->width + 2, b->height + 4, stream_sink(&stream));
+    ok = ok && open_stream(&stream, file, &view, 0);
+    
+    if (ok) {
+        init_game(&game, plan->seed);
+        if (a) reset_autopilot(a);
+        
+        draw_view(&view, &game, 1);
+        ok = emit_frame(&stream, 0);
+    }
+    for (long ticks = 0; ok && ticks < plan->max_ticks && game.status == GAME_RUNNING; ticks++) {
+        uint32_t period = (uint32_t)tick_period_ms(&game);
+        step(&game, next_action(a, &game));
+        draw_view(&view, &game, 0);
+        ok = emit_frame(&stream, period);
+    }
+    
+    if (ok) {
+        printf("streamed:    %ld frames, %.1f bytes/frame\n", stream.frames,
+               stream.frames > 0 ? (double)stream.bytes / stream.frames : 0.0);
+    }
+    close_stream(&stream);
+    free_view(&view);
+    ok = fclose(file) == 0 && ok;
+    if (a) free_autopilot(a);
+    free_game(&game);
+    return ok;
+}
+
+int run_archived(Totals *t, RunPlan *plan, const char *path) {
+    GameState game;
+    Autopilot autopilot;
+    Autopilot *a = plan->autopilot ? &autopilot : NULL;
+    ArchiveWriter archive;
+    if (!create_game(&game, plan->board, NULL)) return 0;
+    if (a && !create_autopilot(a, plan->board, plan->mode)) {
+        free_game(&game);
+        return 0;
+    }
+    
+    ReplayWriter w = {0};
+    int ok = create_archive(&archive, path);
+    for (long n = 0; ok && n < plan->games; n++) {
+        init_game(&game, plan->seed + n);
+        if (a) reset_autopilot(a);
+        
+        ok = restart_recording(&w, &game);
+        long ticks = 0;
+        while (ok && ticks < plan->max_ticks && game.status == GAME_RUNNING) {
+            step(&game, next_action(a, &game));
+            ok = record_tick(&w, &game);
+            ticks++;
+        }
+        
+        ok = ok && append_replay(&archive, &w, &game);
+        record_game(t, &game, ticks);
+    }
+    
+    free_recording(&w);
+    if (archive.file && !finish_archive(&archive)) ok = 0;
+    if (a) free_autopilot(a);
+    free_game(&game);
+    return ok;
+}
+
+int play_replay(const char *path, long target) {
+    ReplayPlayer p;
+    if (!load_replay(&p, path)) {
+        fprintf(stderr, "could not read replay %s\n", path);
+        return 0;
+    }
+    
+    Board board;
+    GameState game;
+    if (!create_board(&board, p.header.width, p.header.height) || !create_game(&game, &board, NULL)) {
+        fprintf(stderr, "replay board %d x %d is not supported\n", p.header.width, p.header.height);
+        free_board(&board);
+        free_replay(&p);
+        return 0;
+    }
+    
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    rewind_replay(&p, &game);
+    seek_replay(&p, &game, target < 0 ? p.header.ticks : (uint32_t)target);
+    double seconds = elapsed_seconds(&start);
+    
+    printf("replay:      %u ticks, %u turns, %zu bytes\n", p.header.ticks, p.header.events, p.size);
+    printf("tick:        %u\n", p.tick);
+    printf("score:       %d\n", game.score);
+    printf("length:      %d\n", game.snake_length);
+    printf("status:      %s\n", game.status == GAME_WON ? "won" : game.status == GAME_OVER ? "over" : "running");
+    printf("seconds:     %.3f\n", seconds);
+    
+    free_game(&game);
+    free_board(&board);
+    free_replay(&p);
+    return 1;
+}
+
+int scan_archive(const char *path, long game) {
+    ReplayArchive archive;
+    if (!open_archive(&archive, path)) {
+        fprintf(stderr, "could not map archive %s\n", path);
+        return 0;
+    }
+    
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    
+    long long score = 0;
+    long long ticks = 0;
+    int best = 0;
+    uint32_t best_game = 0;
+    for (uint32_t i = 0; i < archive.count; i++) {
+        score += archive.scores[i];
+        ticks += archive.ticks[i];
+        if (archive.scores[i] > best) {
+            best = archive.scores[i];
+            best_game = i;
+        }
+    }
+    double seconds = elapsed_seconds(&start);
+    
+    printf("games:       %u\n", archive.count);
+    printf("ticks:       %lld\n", ticks);
+    printf("avg score:   %.1f\n", archive.count > 0 ? (double)score / archive.count : 0.0);
+    printf("best score:  %d (game %u)\n", best, best_game);
+    printf("seconds:     %.6f\n", seconds);
+    
+    int ok = 1;
+    if (game >= 0) {
+        ReplayPlayer p;
+        Board board = {0};
+        GameState g;
+        ok = open_archived_replay(&archive, (uint32_t)game, &p) &&
+             create_board(&board, p.header.width, p.header.height);
+        if (ok && create_game(&g, &board, NULL)) {
+            rewind_replay(&p, &g);
+            seek_replay(&p, &g, p.header.ticks);
+            printf("replayed:    game %ld, seed %llu, %u ticks, score %d (indexed %d), length %d\n", game,
+                   (unsigned long long)p.header.seed, p.tick, g.score, archive.scores[game], g.snake_length);
+            free_game(&g);
+        }
+        else {
+            fprintf(stderr, "could not open game %ld\n", game);
+            ok = 0;
+        }
+        free_board(&board);
+    }
+    
+    close_archive(&archive);
+    return ok;
+}
+
+int run_arena(const Board *board, int snakes, int food, long ticks, uint64_t seed) {
+    Arena arena;
+    if (!create_arena(&arena, board, snakes, food, seed)) {
+        fprintf(stderr, "could not create an arena of %d snakes and %d food on %d cells\n", snakes, food, board->cells);
+        return 0;
+    }
+    
+    double slowest = 0.0;
+    struct timespec start;
+    timespec_get(&start, TIME_UTC);
+    
+    for (long t = 0; t < ticks; t++) {
+        struct timespec tick;
+        timespec_get(&tick, TIME_UTC);
+        plan_arena(&arena);
+        step_arena(&arena);
+        
+        double seconds = elapsed_seconds(&tick);
+        if (seconds > slowest) slowest = seconds;
+    }
+    
+    double seconds = elapsed_seconds(&start);
+    int best = 0;
+    for (int i = 0; i < arena.snake_count; i++) {
+        if (arena.snakes[i].best_length > best) best = arena.snakes[i].best_length;
+    }
+    
+    printf("snakes:      %d\n", arena.snake_count);
+    printf("alive:       %d\n", arena.alive);
+    printf("deaths:      %ld\n", arena.deaths);
+    printf("body cells:  %d\n", arena_length(&arena));
+    printf("best length: %d\n", best);
+    printf("ticks:       %ld\n", ticks);
+    printf("avg tick us: %.2f\n", ticks > 0 ? seconds * 1e6 / ticks : 0.0);
+    printf("max tick us: %.2f\n", slowest * 1e6);
+    free_arena(&arena);
+    return 1;
+}
+
+double elapsed_seconds(struct timespec *start) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
@@ -0,0 +1,297 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_core.h"
+#include "snake_autopilot.h"
+#include "snake_net.h"
+
+#define READ_CHUNK 4096
+#define DEFAULT_PLAYERS 100
+
+typedef struct {
+    int fd;
+    int ready;
+    uint32_t tick;
+    GameState game;
+    Autopilot autopilot;
+    NetBuffer in;
+    NetBuffer out;
+} Player;
+
+typedef struct {
+    Board board;
+    int have_board;
+    Player *players;
+    struct pollfd *polls;
+    int count;
+    int open;
+    long long ticks;
+    long long bytes;
+    long games;
+    long desyncs;
+} Load;
+
+int64_t now_ns();
+int connect_player(const char *host, const char *port);
+int start_player(Load *l, Player *p, NetReader *r);
+int tick_player(Load *l, Player *p, NetReader *r);
+int read_player(Load *l, Player *p);
+int send_player(Player *p);
+void close_player(Load *l, Player *p);
+
+int main(int argc, char *argv[]) {
+    const char *host = "127.0.0.1";
+    const char *port = "7778";
+    int count = DEFAULT_PLAYERS;
+    long seconds = 10;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+            host = argv[++i];
+        }
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = argv[++i];
+        }
+        else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atol(argv[++i]);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--host HOST] [--port N] [--players N] [--seconds N]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    Load load = {0};
+    load.players = alloc_aligned(sizeof(Player) * (size_t)(count > 0 ? count : 1));
+    load.polls = calloc((size_t)(count > 0 ? count : 1), sizeof(struct pollfd));
+    if (!load.players || !load.polls) return 1;
+    
+    memset(load.players, 0, sizeof(Player) * (size_t)(count > 0 ? count : 1));
+    
+    for (int i = 0; i < count; i++) {
+        Player *p = &load.players[i];
+        p->fd = connect_player(host, port);
+        if (p->fd < 0) {
+            fprintf(stderr, "connected %d of %d players to %s:%s\n", i, count, host, port);
+            break;
+        }
+        
+        load.count++;
+        load.open++;
+        put_message(&p->out, NET_HELLO, NET_VERSION);
+        if (!send_player(p)) {
+            close_player(&load, p);
+        }
+    }
+    
+    int64_t start = now_ns();
+    int64_t end = start + (int64_t)seconds * 1000000000;
+    while (load.open > 0 && now_ns() < end) {
+        for (int i = 0; i < load.count; i++) {
+            load.polls[i].fd = load.players[i].fd;
+            load.polls[i].events = POLLIN;
+        }
+        
+        if (poll(load.polls, (nfds_t)load.count, 100) <= 0) continue;
+        
+        for (int i = 0; i < load.count; i++) {
+            Player *p = &load.players[i];
+            if (p->fd < 0 || !load.polls[i].revents) continue;
+            
+            if (!read_player(&load, p) || !send_player(p)) {
+                close_player(&load, p);
+            }
+        }
+    }
+    
+    double elapsed = (double)(now_ns() - start) / 1e9;
+    printf("players %d open %d ticks %lld (%.0f/s) games %ld desyncs %ld received %lld bytes\n",
+           load.count, load.open, load.ticks, elapsed > 0 ? (double)load.ticks / elapsed : 0.0,
+           load.games, load.desyncs, load.bytes);
+    
+    for (int i = 0; i < load.count; i++) {
+        Player *p = &load.players[i];
+        close_player(&load, p);
+        if (p->game.board) {
+            free_game(&p->game);
+            free_autopilot(&p->autopilot);
+        }
+        free_net_buffer(&p->in);
+        free_net_buffer(&p->out);
+    }
+    if (load.have_board) {
+        free_board(&load.board);
+    }
+    free(load.polls);
+    free_aligned(load.players);
+    return load.desyncs == 0 ? 0 : 1;
+}
+
+int64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int connect_player(const char *host, const char *port) {
+    struct addrinfo hints;
+    struct addrinfo *found;
+    int fd = -1;
+    
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(host, port, &hints, &found) != 0) return -1;
+    
+    for (struct addrinfo *ai = found; ai && fd < 0; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd >= 0 && connect(fd, ai->ai_addr, ai->ai_addrlen) < 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(found);
+    
+    if (fd >= 0) {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+    return fd;
+}
+
+int start_player(Load *l, Player *p, NetReader *r) {
+    uint32_t low;
+    uint32_t high;
+    uint32_t width;
+    uint32_t height;
+    
+    if (!net_get_u32(r, &low) || !net_get_u32(r, &high) || !net_get_varint(r, &width) || !net_get_varint(r, &height)) return 0;
+    
+    if (!l->have_board) {
+        if (!create_board(&l->board, (int)width, (int)height)) return 0;
+        l->have_board = 1;
+    }
+    if ((int)width != l->board.width || (int)height != l->board.height) return 0;
+    
+    if (!p->game.board) {
+        if (!create_game(&p->game, &l->board, NULL)) return 0;
+        if (!create_autopilot(&p->autopilot, &l->board, AUTOPILOT_PATH)) {
+            free_game(&p->game);
+            return 0;
+        }
+    }
+    else {
+        l->games++;
+    }
+    
+    init_game(&p->game, (uint64_t)high << 32 | low);
+    reset_autopilot(&p->autopilot);
+    p->tick = 0;
+    p->ready = 1;
+    return 1;
+}
+
+int tick_player(Load *l, Player *p, NetReader *r) {
+    uint32_t tick;
+    unsigned char state;
+    uint32_t food;
+    uint32_t checksum;
+    
+    if (!p->ready || !net_get_varint(r, &tick) || !net_get_byte(r, &state)) return 0;
+    if (!net_get_varint(r, &food) || !net_get_u32(r, &checksum)) return 0;
+    
+    l->ticks++;
+    step(&p->game, state & 3);
+    if (tick != p->tick + 1 || p->game.status != state >> 2 || p->game.current_dir != (state & 3) ||
+        p->game.food != food || game_checksum(&p->game) != checksum) {
+        l->desyncs++;
+        p->ready = 0;
+        return 0;
+    }
+    
+    p->tick = tick;
+    if (p->game.status == GAME_RUNNING) {
+        int action = autopilot_action(&p->autopilot, &p->game);
+        if (action != ACTION_NONE) {
+            put_message(&p->out, NET_TURN, (uint32_t)action);
+        }
+    }
+    return 1;
+}
+
+int read_player(Load *l, Player *p) {
+    for (;;) {
+        if (!net_reserve(&p->in, READ_CHUNK)) return 0;
+        
+        ssize_t got = recv(p->fd, p->in.data + p->in.size, p->in.capacity - p->in.size, 0);
+        if (got == 0) return 0;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            break;
+        }
+        p->in.size += (size_t)got;
+        l->bytes += got;
+    }
+    
+    size_t pos = 0;
+    for (;;) {
+        int type;
+        NetReader payload;
+        long used = next_message(p->in.data + pos, p->in.size - pos, &type, &payload);
+        if (used < 0) return 0;
+        if (used == 0) break;
+        
+        pos += (size_t)used;
+        if (type == NET_START) {
+            if (!start_player(l, p, &payload)) return 0;
+        }
+        else if (type != NET_TICK || !tick_player(l, p, &payload)) {
+            return 0;
+        }
+    }
+    
+    memmove(p->in.data, p->in.data + pos, p->in.size - pos);
+    p->in.size -= pos;
+    return 1;
+}
+
+int send_player(Player *p) {
+    size_t sent = 0;
+    
+    while (sent < p->out.size) {
+        ssize_t put = send(p->fd, p->out.data + sent, p->out.size - sent, MSG_NOSIGNAL);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        sent += (size_t)put;
+    }
+    
+    p->out.size = 0;
+    return 1;
+}
+
+void close_player(Load *l, Player *p) {
+    if (p->fd < 0) return;
+    
+    close(p->fd);
+    p->fd = -1;
+    l->open--;
+}
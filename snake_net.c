@@ -0,0 +1,457 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_net.h"
+
+uint32_t mix_checksum(uint32_t hash, uint32_t value);
+int step_direction(const Board *b, Cell from, Cell to);
+int put_snake(NetBuffer *out, const Arena *a, const ArenaSnake *s);
+int get_cell(NetReader *r, const Board *b, Cell *c);
+int read_board(NetMirror *m, int width, int height, int snakes, int food);
+int get_snake(NetMirror *m, NetReader *r, int i);
+int get_placements(NetMirror *m, NetReader *r);
+
+int net_reserve(NetBuffer *b, size_t extra) {
+    if (b->size + extra <= b->capacity) return 1;
+    
+    size_t capacity = b->capacity > 0 ? b->capacity : 256;
+    while (capacity < b->size + extra) {
+        capacity *= 2;
+    }
+    
+    unsigned char *data = realloc(b->data, capacity);
+    if (!data) return 0;
+    
+    b->data = data;
+    b->capacity = capacity;
+    return 1;
+}
+
+int net_put_byte(NetBuffer *b, unsigned char value) {
+    if (!net_reserve(b, 1)) return 0;
+    
+    b->data[b->size++] = value;
+    return 1;
+}
+
+int net_put_varint(NetBuffer *b, uint32_t value) {
+    if (!net_reserve(b, 5)) return 0;
+    
+    while (value >= 0x80) {
+        b->data[b->size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    b->data[b->size++] = (unsigned char)value;
+    return 1;
+}
+
+int net_put_u32(NetBuffer *b, uint32_t value) {
+    if (!net_reserve(b, 4)) return 0;
+    
+    for (int i = 0; i < 4; i++) {
+        b->data[b->size++] = (unsigned char)(value >> (8 * i));
+    }
+    return 1;
+}
+
+void free_net_buffer(NetBuffer *b) {
+    free(b->data);
+    memset(b, 0, sizeof(*b));
+}
+
+size_t begin_message(NetBuffer *b, NetMessage type) {
+    size_t start = b->size;
+    
+    net_put_u32(b, 0);
+    net_put_byte(b, (unsigned char)type);
+    return start;
+}
+
+void end_message(NetBuffer *b, size_t start) {
+    uint32_t length = (uint32_t)(b->size - start - NET_HEADER_SIZE);
+    
+    for (int i = 0; i < 4; i++) {
+        b->data[start + i] = (unsigned char)(length >> (8 * i));
+    }
+}
+
+int put_message(NetBuffer *b, NetMessage type, uint32_t value) {
+    size_t start = begin_message(b, type);
+    int ok = net_put_varint(b, value);
+    
+    end_message(b, start);
+    return ok && b->size > start + NET_HEADER_SIZE;
+}
+
+long next_message(const unsigned char *data, size_t size, int *type, NetReader *payload) {
+    if (size < NET_HEADER_SIZE) return 0;
+    
+    uint32_t length = (uint32_t)data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16 | (uint32_t)data[3] << 24;
+    if (length > NET_MAX_MESSAGE) return -1;
+    if (size < NET_HEADER_SIZE + (size_t)length) return 0;
+    
+    *type = data[4];
+    payload->data = data + NET_HEADER_SIZE;
+    payload->size = length;
+    payload->pos = 0;
+    return NET_HEADER_SIZE + (long)length;
+}
+
+int net_get_byte(NetReader *r, unsigned char *value) {
+    if (r->pos >= r->size) return 0;
+    
+    *value = r->data[r->pos++];
+    return 1;
+}
+
+int net_get_varint(NetReader *r, uint32_t *value) {
+    uint32_t result = 0;
+    
+    for (int shift = 0; shift < 35 && r->pos < r->size; shift += 7) {
+        unsigned char byte = r->data[r->pos++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+int net_get_u32(NetReader *r, uint32_t *value) {
+    if (r->size - r->pos < 4) return 0;
+    
+    const unsigned char *in = &r->data[r->pos];
+    *value = (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 | (uint32_t)in[3] << 24;
+    r->pos += 4;
+    return 1;
+}
+
+int put_start(NetBuffer *b, const GameState *g) {
+    size_t start = begin_message(b, NET_START);
+    int ok = net_put_u32(b, (uint32_t)g->seed) && net_put_u32(b, (uint32_t)(g->seed >> 32));
+    
+    ok = ok && net_put_varint(b, (uint32_t)g->board->width);
+    ok = ok && net_put_varint(b, (uint32_t)g->board->height);
+    end_message(b, start);
+    return ok;
+}
+
+int put_tick(NetBuffer *b, uint32_t tick, const GameState *g) {
+    size_t start = begin_message(b, NET_TICK);
+    int ok = net_put_varint(b, tick) && net_put_byte(b, (unsigned char)(g->current_dir | g->status << 2));
+    
+    ok = ok && net_put_varint(b, g->food);
+    ok = ok && net_put_u32(b, game_checksum(g));
+    end_message(b, start);
+    return ok;
+}
+
+uint32_t mix_checksum(uint32_t hash, uint32_t value) {
+    return (hash ^ value) * 0x01000193u;
+}
+
+uint32_t game_checksum(const GameState *g) {
+    uint32_t hash = mix_checksum(0x811C9DC5u, g->snake[g->snake_head]);
+    
+    hash = mix_checksum(hash, (uint32_t)g->snake_length);
+    return mix_checksum(hash, (uint32_t)g->score);
+}
+
+uint32_t arena_checksum(const Arena *a) {
+    uint32_t hash = mix_checksum(0x811C9DC5u, a->tick);
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        const ArenaSnake *s = &a->snakes[i];
+        if (!s->alive) continue;
+        
+        hash = mix_checksum(hash, (uint32_t)i);
+        hash = mix_checksum(hash, s->body[s->head]);
+        hash = mix_checksum(hash, (uint32_t)s->length);
+    }
+    
+    hash = mix_checksum(hash, (uint32_t)a->food_count);
+    return mix_checksum(hash, (uint32_t)a->free_count);
+}
+
+int step_direction(const Board *b, Cell from, Cell to) {
+    for (int d = UP; d <= RIGHT; d++) {
+        if (next_cell(b, from, (Direction)d) == to) return d;
+    }
+    
+    return -1;
+}
+
+int put_snake(NetBuffer *out, const Arena *a, const ArenaSnake *s) {
+    int ok = net_put_byte(out, (unsigned char)(s->alive | s->human << 1));
+    if (!s->alive) return ok;
+    
+    Cell prev = s->body[s->tail];
+    ok = ok && net_put_byte(out, s->dir);
+    ok = ok && net_put_varint(out, (uint32_t)s->score);
+    ok = ok && net_put_varint(out, (uint32_t)s->grow);
+    ok = ok && net_put_varint(out, (uint32_t)s->length);
+    ok = ok && net_put_varint(out, prev);
+    if (!ok || !net_reserve(out, (size_t)s->length / 4 + 1)) return 0;
+    
+    unsigned char packed = 0;
+    for (int k = 1; k < s->length; k++) {
+        Cell c = s->body[(s->tail + k) & s->mask];
+        packed |= (unsigned char)(step_direction(a->board, prev, c) << 2 * ((k - 1) & 3));
+        if ((k & 3) == 0) {
+            out->data[out->size++] = packed;
+            packed = 0;
+        }
+        prev = c;
+    }
+    if ((s->length - 1) & 3) {
+        out->data[out->size++] = packed;
+    }
+    return 1;
+}
+
+int encode_snapshot(NetBuffer *out, const Arena *a) {
+    size_t start = begin_message(out, NET_SNAPSHOT);
+    int ok = net_put_varint(out, a->tick);
+    
+    ok = ok && net_put_varint(out, (uint32_t)a->board->width);
+    ok = ok && net_put_varint(out, (uint32_t)a->board->height);
+    ok = ok && net_put_varint(out, (uint32_t)a->snake_count);
+    ok = ok && net_put_varint(out, (uint32_t)a->food_target);
+    for (int i = 0; ok && i < a->snake_count; i++) {
+        ok = put_snake(out, a, &a->snakes[i]);
+    }
+    
+    ok = ok && net_put_varint(out, (uint32_t)a->food_count);
+    for (int i = 0; ok && i < a->food_count; i++) {
+        ok = net_put_varint(out, a->food[i]);
+    }
+    
+    ok = ok && net_put_u32(out, arena_checksum(a));
+    if (ok) {
+        end_message(out, start);
+    }
+    else {
+        out->size = start;
+    }
+    return ok;
+}
+
+int encode_delta(NetBuffer *out, const Arena *a) {
+    size_t start = begin_message(out, NET_DELTA);
+    int ok = net_put_varint(out, a->tick) && net_reserve(out, (size_t)a->snake_count / 2 + 1);
+    int moved = 0;
+    int spawned = 0;
+    unsigned char packed = 0;
+    
+    for (int i = 0; ok && i < a->snake_count; i++) {
+        const ArenaSnake *s = &a->snakes[i];
+        spawned += s->spawned;
+        if (!(s->move & ARENA_MOVE_MOVED)) continue;
+        
+        packed |= (unsigned char)((s->move & 15) << 4 * (moved & 1));
+        if (moved++ & 1) {
+            out->data[out->size++] = packed;
+            packed = 0;
+        }
+    }
+    if (ok && (moved & 1)) {
+        out->data[out->size++] = packed;
+    }
+    
+    ok = ok && net_put_varint(out, (uint32_t)spawned);
+    for (int i = 0, last = -1; ok && i < a->snake_count; i++) {
+        const ArenaSnake *s = &a->snakes[i];
+        if (!s->spawned) continue;
+        
+        ok = net_put_varint(out, (uint32_t)(i - last - 1));
+        ok = ok && net_put_varint(out, s->body[s->head]);
+        ok = ok && net_put_byte(out, s->dir);
+        last = i;
+    }
+    
+    ok = ok && net_put_varint(out, (uint32_t)a->food_added);
+    for (int i = a->food_count - a->food_added; ok && i < a->food_count; i++) {
+        ok = net_put_varint(out, a->food[i]);
+    }
+    
+    ok = ok && net_put_u32(out, arena_checksum(a));
+    if (ok) {
+        end_message(out, start);
+    }
+    else {
+        out->size = start;
+    }
+    return ok;
+}
+
+void init_mirror(NetMirror *m) {
+    memset(m, 0, sizeof(*m));
+    m->snake = -1;
+}
+
+void free_mirror(NetMirror *m) {
+    if (m->arena.board) {
+        free_arena(&m->arena);
+        free_board(&m->board);
+    }
+    
+    int snake = m->snake;
+    init_mirror(m);
+    m->snake = snake;
+}
+
+int get_cell(NetReader *r, const Board *b, Cell *c) {
+    uint32_t value;
+    
+    if (!net_get_varint(r, &value) || value >= (uint32_t)b->cells) return 0;
+    
+    *c = value;
+    return 1;
+}
+
+int read_board(NetMirror *m, int width, int height, int snakes, int food) {
+    Arena *a = &m->arena;
+    
+    if (a->board && m->board.width == width && m->board.height == height && a->snake_count == snakes && a->food_target == food) {
+        clear_arena(a);
+        return 1;
+    }
+    
+    free_mirror(m);
+    if (!create_board(&m->board, width, height)) return 0;
+    if (!alloc_arena(a, &m->board, snakes, food)) {
+        free_board(&m->board);
+        memset(a, 0, sizeof(*a));
+        return 0;
+    }
+    
+    rng_seed(&a->rng, (uint64_t)(m->snake + 1));
+    return 1;
+}
+
+int get_snake(NetMirror *m, NetReader *r, int i) {
+    Arena *a = &m->arena;
+    ArenaSnake *s = &a->snakes[i];
+    unsigned char flags;
+    unsigned char dir;
+    uint32_t score;
+    uint32_t grow;
+    uint32_t length;
+    Cell c;
+    
+    if (!net_get_byte(r, &flags)) return 0;
+    
+    s->human = flags >> 1 & 1;
+    if (!(flags & 1)) return 1;
+    
+    if (!net_get_byte(r, &dir) || dir > RIGHT) return 0;
+    if (!net_get_varint(r, &score) || !net_get_varint(r, &grow) || !net_get_varint(r, &length)) return 0;
+    if (length == 0 || length > (uint32_t)m->board.cells || !get_cell(r, &m->board, &c)) return 0;
+    if (!place_snake(a, i, c, (Direction)dir)) return 0;
+    
+    unsigned char packed = 0;
+    for (uint32_t k = 1; k < length; k++) {
+        if (((k - 1) & 3) == 0 && !net_get_byte(r, &packed)) return 0;
+        
+        c = next_cell(&m->board, c, (Direction)(packed >> 2 * ((k - 1) & 3) & 3));
+        if (a->occupant[c] != ARENA_EMPTY || !push_head(a, i, c)) return 0;
+    }
+    
+    s->score = (int)score;
+    s->grow = (int)grow;
+    return 1;
+}
+
+int get_placements(NetMirror *m, NetReader *r) {
+    Arena *a = &m->arena;
+    uint32_t count;
+    Cell c;
+    
+    if (!net_get_varint(r, &count)) return 0;
+    
+    for (uint32_t k = 0, last = (uint32_t)-1; k < count; k++) {
+        uint32_t gap;
+        unsigned char dir;
+        if (!net_get_varint(r, &gap) || gap >= (uint32_t)a->snake_count - last - 1) return 0;
+        
+        last += gap + 1;
+        if (!get_cell(r, &m->board, &c) || !net_get_byte(r, &dir) || dir > RIGHT) return 0;
+        if (!place_snake(a, (int)last, c, (Direction)dir)) return 0;
+    }
+    
+    if (!net_get_varint(r, &count) || count > (uint32_t)(a->food_target - a->food_count)) return 0;
+    
+    for (uint32_t k = 0; k < count; k++) {
+        if (!get_cell(r, &m->board, &c) || !place_food(a, c)) return 0;
+    }
+    
+    return 1;
+}
+
+int decode_snapshot(NetMirror *m, NetReader *r) {
+    uint32_t tick;
+    uint32_t width;
+    uint32_t height;
+    uint32_t snakes;
+    uint32_t food;
+    uint32_t checksum;
+    
+    m->ready = 0;
+    if (!net_get_varint(r, &tick) || !net_get_varint(r, &width) || !net_get_varint(r, &height)) return 0;
+    if (!net_get_varint(r, &snakes) || !net_get_varint(r, &food)) return 0;
+    if (width < 2 || height < 2 || width > 65536 || height > 65536 || snakes > ARENA_MAX_SNAKES) return 0;
+    if ((uint64_t)width * height > NET_MAX_MESSAGE || (uint64_t)snakes + food > (uint64_t)width * height) return 0;
+    if (m->snake >= (int)snakes) return 0;
+    if (!read_board(m, (int)width, (int)height, (int)snakes, (int)food)) return 0;
+    
+    Arena *a = &m->arena;
+    for (int i = 0; i < a->snake_count; i++) {
+        if (!get_snake(m, r, i)) return 0;
+    }
+    
+    uint32_t count;
+    Cell c;
+    if (!net_get_varint(r, &count) || count > (uint32_t)(a->food_target - a->food_count)) return 0;
+    
+    for (uint32_t k = 0; k < count; k++) {
+        if (!get_cell(r, &m->board, &c) || !place_food(a, c)) return 0;
+    }
+    
+    a->tick = tick;
+    if (!net_get_u32(r, &checksum) || checksum != arena_checksum(a)) return 0;
+    
+    m->ready = 1;
+    return 1;
+}
+
+int decode_delta(NetMirror *m, NetReader *r) {
+    Arena *a = &m->arena;
+    uint32_t tick;
+    uint32_t checksum;
+    unsigned char packed = 0;
+    int moved = 0;
+    
+    if (!m->ready) return 0;
+    
+    m->ready = 0;
+    if (!net_get_varint(r, &tick) || tick != a->tick + 1) return 0;
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        ArenaSnake *s = &a->snakes[i];
+        s->move = 0;
+        if (!s->alive) continue;
+        
+        if (!(moved & 1) && !net_get_byte(r, &packed)) return 0;
+        
+        s->move = (unsigned char)(ARENA_MOVE_MOVED | (packed >> 4 * (moved & 1) & 15));
+        moved++;
+    }
+    
+    if (!apply_moves(a) || !get_placements(m, r)) return 0;
+    if (!net_get_u32(r, &checksum) || checksum != arena_checksum(a)) return 0;
+    
+    m->ready = 1;
+    return 1;
+}
@@ -0,0 +1,72 @@
+#ifndef SNAKE_NET_H
+#define SNAKE_NET_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snake_core.h"
+#include "snake_arena.h"
+
+#define NET_VERSION 1
+#define NET_HEADER_SIZE 5
+#define NET_MAX_MESSAGE (64u << 20)
+#define NET_DEFAULT_PORT 7777
+#define NET_SESSION_PORT 7778
+#define NET_START_MAX (NET_HEADER_SIZE + 18)
+#define NET_TICK_MAX (NET_HEADER_SIZE + 15)
+
+typedef enum {
+    NET_HELLO = 1,
+    NET_WELCOME,
+    NET_SNAPSHOT,
+    NET_DELTA,
+    NET_TURN,
+    NET_RESYNC,
+    NET_START,
+    NET_TICK,
+    NET_WATCH
+} NetMessage;
+
+typedef struct {
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} NetBuffer;
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+} NetReader;
+
+typedef struct {
+    Board board;
+    Arena arena;
+    int ready;
+    int snake;
+} NetMirror;
+
+int net_reserve(NetBuffer *b, size_t extra);
+int net_put_byte(NetBuffer *b, unsigned char value);
+int net_put_varint(NetBuffer *b, uint32_t value);
+int net_put_u32(NetBuffer *b, uint32_t value);
+void free_net_buffer(NetBuffer *b);
+size_t begin_message(NetBuffer *b, NetMessage type);
+void end_message(NetBuffer *b, size_t start);
+int put_message(NetBuffer *b, NetMessage type, uint32_t value);
+long next_message(const unsigned char *data, size_t size, int *type, NetReader *payload);
+int net_get_byte(NetReader *r, unsigned char *value);
+int net_get_varint(NetReader *r, uint32_t *value);
+int net_get_u32(NetReader *r, uint32_t *value);
+int put_start(NetBuffer *b, const GameState *g);
+int put_tick(NetBuffer *b, uint32_t tick, const GameState *g);
+uint32_t game_checksum(const GameState *g);
+uint32_t arena_checksum(const Arena *a);
+int encode_snapshot(NetBuffer *out, const Arena *a);
+int encode_delta(NetBuffer *out, const Arena *a);
+void init_mirror(NetMirror *m);
+void free_mirror(NetMirror *m);
+int decode_snapshot(NetMirror *m, NetReader *r);
+int decode_delta(NetMirror *m, NetReader *r);
+
+#endif
@@ -0,0 +1,88 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_pipeline.h"
+
+void init_inputs(InputQueue *q) {
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+}
+
+int push_input(InputQueue *q, int command, int64_t time) {
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&q->head, memory_order_acquire);
+    if (tail - head == INPUT_QUEUE_SIZE) return 0;
+    
+    InputEvent *e = &q->events[tail % INPUT_QUEUE_SIZE];
+    e->command = command;
+    e->time = time;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return 1;
+}
+
+int pop_input(InputQueue *q, InputEvent *e) {
+    unsigned head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+    if (head == tail) return 0;
+    
+    *e = q->events[head % INPUT_QUEUE_SIZE];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return 1;
+}
+
+int create_frames(FrameBuffer *f, const Board *b) {
+    memset(f, 0, sizeof(*f));
+    for (int i = 0; i < FRAME_SLOTS; i++) {
+        f->frames[i].state = malloc(snapshot_capacity(b));
+        if (!f->frames[i].state) {
+            free_frames(f);
+            return 0;
+        }
+    }
+    
+    atomic_init(&f->middle, 1);
+    f->back = 0;
+    f->front = 2;
+    return 1;
+}
+
+void free_frames(FrameBuffer *f) {
+    for (int i = 0; i < FRAME_SLOTS; i++) {
+        free(f->frames[i].state);
+        f->frames[i].state = NULL;
+    }
+}
+
+void publish_frame(FrameBuffer *f, GameState *g, int64_t now, int64_t input_time) {
+    Frame *frame = &f->frames[f->back];
+    
+    snapshot(g, frame->state);
+    frame->sequence = ++f->sequence;
+    frame->published = now;
+    frame->input_time = f->unseen_input ? f->unseen_input : input_time;
+    frame->dirty_count = g->dirty_count;
+    frame->full_redraw = g->full_redraw;
+    memcpy(frame->dirty_cells, g->dirty_cells, sizeof(Cell) * (size_t)g->dirty_count);
+    g->dirty_count = 0;
+    g->full_redraw = 0;
+    
+    int previous = atomic_exchange_explicit(&f->middle, f->back | FRAME_FRESH, memory_order_acq_rel);
+    f->back = previous & (FRAME_FRESH - 1);
+    f->unseen_input = (previous & FRAME_FRESH) ? f->frames[f->back].input_time : 0;
+}
+
+const Frame *acquire_frame(FrameBuffer *f, GameState *shown) {
+    if (!(atomic_load_explicit(&f->middle, memory_order_relaxed) & FRAME_FRESH)) return NULL;
+    
+    int previous = atomic_exchange_explicit(&f->middle, f->front, memory_order_acq_rel);
+    f->front = previous & (FRAME_FRESH - 1);
+    
+    const Frame *frame = &f->frames[f->front];
+    if (!restore(shown, frame->state)) return NULL;
+    
+    shown->full_redraw = frame->full_redraw || frame->sequence != f->shown_sequence + 1;
+    shown->dirty_count = frame->dirty_count;
+    memcpy(shown->dirty_cells, frame->dirty_cells, sizeof(Cell) * (size_t)frame->dirty_count);
+    f->shown_sequence = frame->sequence;
+    return frame;
+}
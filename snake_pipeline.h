@@ -0,0 +1,61 @@
+#ifndef SNAKE_PIPELINE_H
+#define SNAKE_PIPELINE_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "snake_core.h"
+
+#define INPUT_QUEUE_SIZE 64
+#define FRAME_SLOTS 3
+#define FRAME_FRESH 4
+
+typedef enum {
+    INPUT_UP = UP,
+    INPUT_DOWN = DOWN,
+    INPUT_LEFT = LEFT,
+    INPUT_RIGHT = RIGHT,
+    INPUT_PAUSE,
+    INPUT_QUIT
+} InputCommand;
+
+typedef struct {
+    int command;
+    int64_t time;
+} InputEvent;
+
+typedef struct {
+    CACHE_ALIGN atomic_uint head;
+    CACHE_ALIGN atomic_uint tail;
+    InputEvent events[INPUT_QUEUE_SIZE];
+} InputQueue;
+
+typedef struct {
+    uint64_t sequence;
+    int64_t published;
+    int64_t input_time;
+    int dirty_count;
+    int full_redraw;
+    Cell dirty_cells[MAX_DIRTY];
+    unsigned char *state;
+} Frame;
+
+typedef struct {
+    Frame frames[FRAME_SLOTS];
+    CACHE_ALIGN atomic_int middle;
+    CACHE_ALIGN int back;
+    uint64_t sequence;
+    int64_t unseen_input;
+    CACHE_ALIGN int front;
+    uint64_t shown_sequence;
+} FrameBuffer;
+
+void init_inputs(InputQueue *q);
+int push_input(InputQueue *q, int command, int64_t time);
+int pop_input(InputQueue *q, InputEvent *e);
+int create_frames(FrameBuffer *f, const Board *b);
+void free_frames(FrameBuffer *f);
+void publish_frame(FrameBuffer *f, GameState *g, int64_t now, int64_t input_time);
+const Frame *acquire_frame(FrameBuffer *f, GameState *shown);
+
+#endif
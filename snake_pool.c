@@ -0,0 +1,92 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_pool.h"
+
+size_t line_round(size_t size);
+int add_slab(GamePool *p);
+
+void init_game_pool(GamePool *p, const Board *b, int per_slab) {
+    memset(p, 0, sizeof(*p));
+    p->board = b;
+    p->per_slab = per_slab > 0 ? per_slab : POOL_SLAB_GAMES;
+    p->stride = line_round(sizeof(PooledGame)) + line_round(sizeof(uint64_t) * (size_t)b->words);
+}
+
+size_t line_round(size_t size) {
+    return (size + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+}
+
+void free_game_pool(GamePool *p) {
+    for (int s = 0; s < p->slab_count; s++) {
+        unsigned char *slab = p->slabs[s];
+        for (int i = 0; i < p->per_slab; i++) {
+            free_game(&((PooledGame *)(slab + p->stride * (size_t)i))->game);
+        }
+        free_aligned(slab);
+    }
+    
+    free(p->slabs);
+    memset(p, 0, sizeof(*p));
+}
+
+int add_slab(GamePool *p) {
+    if (p->slab_count == p->slab_capacity) {
+        int capacity = p->slab_capacity > 0 ? p->slab_capacity * 2 : 8;
+        void **slabs = realloc(p->slabs, sizeof(void *) * (size_t)capacity);
+        if (!slabs) return 0;
+        
+        p->slabs = slabs;
+        p->slab_capacity = capacity;
+    }
+    
+    unsigned char *slab = alloc_aligned(p->stride * (size_t)p->per_slab);
+    if (!slab) return 0;
+    
+    size_t header = line_round(sizeof(PooledGame));
+    for (int i = 0; i < p->per_slab; i++) {
+        PooledGame *pg = (PooledGame *)(slab + p->stride * (size_t)i);
+        if (!create_game(&pg->game, p->board, (uint64_t *)((unsigned char *)pg + header))) {
+            for (int k = 0; k < i; k++) {
+                free_game(&((PooledGame *)(slab + p->stride * (size_t)k))->game);
+            }
+            free_aligned(slab);
+            return 0;
+        }
+    }
+    
+    for (int i = p->per_slab - 1; i >= 0; i--) {
+        PooledGame *pg = (PooledGame *)(slab + p->stride * (size_t)i);
+        pg->next_free = p->free_list;
+        p->free_list = pg;
+    }
+    p->slabs[p->slab_count++] = slab;
+    return 1;
+}
+
+GameState *acquire_game(GamePool *p) {
+    if (!p->free_list && !add_slab(p)) return NULL;
+    
+    PooledGame *pg = p->free_list;
+    p->free_list = pg->next_free;
+    p->live++;
+    return &pg->game;
+}
+
+void release_game(GamePool *p, GameState *g) {
+    PooledGame *pg = (PooledGame *)g;
+    
+    pg->next_free = p->free_list;
+    p->free_list = pg;
+    p->live--;
+}
+
+size_t pooled_game_size(const Board *b) {
+    size_t ring = INITIAL_CAPACITY;
+    while (ring < (size_t)b->cells + 1) {
+        ring *= 2;
+    }
+    
+    return line_round(sizeof(PooledGame)) + line_round(sizeof(uint64_t) * (size_t)b->words) +
+           sizeof(uint32_t) * (size_t)b->blocks + sizeof(Cell) * ring;
+}
@@ -0,0 +1,32 @@
+#ifndef SNAKE_POOL_H
+#define SNAKE_POOL_H
+
+#include <stddef.h>
+
+#include "snake_core.h"
+
+#define POOL_SLAB_GAMES 64
+
+typedef struct PooledGame {
+    GameState game;
+    struct PooledGame *next_free;
+} PooledGame;
+
+typedef struct {
+    const Board *board;
+    size_t stride;
+    int per_slab;
+    PooledGame *free_list;
+    void **slabs;
+    int slab_count;
+    int slab_capacity;
+    long live;
+} GamePool;
+
+void init_game_pool(GamePool *p, const Board *b, int per_slab);
+void free_game_pool(GamePool *p);
+GameState *acquire_game(GamePool *p);
+void release_game(GamePool *p, GameState *g);
+size_t pooled_game_size(const Board *b);
+
+#endif
@@ -0,0 +1,244 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_replay.h"
+
+int reserve_bytes(ReplayWriter *w, size_t extra);
+int put_varint(ReplayWriter *w, uint32_t value);
+int get_varint(ReplayPlayer *p, uint32_t *value);
+void put_le(unsigned char *out, uint64_t value, int bytes);
+uint64_t get_le(const unsigned char *in, int bytes);
+void write_header(const ReplayHeader *h, unsigned char *out);
+void next_event(ReplayPlayer *p);
+
+int begin_recording(ReplayWriter *w, const GameState *g) {
+    memset(w, 0, sizeof(*w));
+    return restart_recording(w, g);
+}
+
+int restart_recording(ReplayWriter *w, const GameState *g) {
+    unsigned char *data = w->data;
+    size_t capacity = w->capacity;
+    
+    memset(w, 0, sizeof(*w));
+    w->data = data;
+    w->capacity = capacity;
+    w->header.seed = g->seed;
+    w->header.width = g->board->width;
+    w->header.height = g->board->height;
+    w->last_dir = g->current_dir;
+    
+    if (!reserve_bytes(w, REPLAY_HEADER_SIZE + 256)) return 0;
+    w->size = REPLAY_HEADER_SIZE;
+    return 1;
+}
+
+int record_tick(ReplayWriter *w, const GameState *g) {
+    if (g->paused) return 1;
+    
+    w->header.ticks++;
+    if (g->current_dir == w->last_dir) return 1;
+    
+    uint32_t delta = w->header.ticks - w->last_tick;
+    w->last_tick = w->header.ticks;
+    w->last_dir = g->current_dir;
+    w->header.events++;
+    return put_varint(w, delta << 2 | g->current_dir);
+}
+
+void seal_recording(ReplayWriter *w) {
+    write_header(&w->header, w->data);
+}
+
+int save_replay(ReplayWriter *w, const char *path) {
+    seal_recording(w);
+    
+    FILE *f = fopen(path, "wb");
+    if (!f) return 0;
+    
+    int ok = fwrite(w->data, 1, w->size, f) == w->size;
+    return fclose(f) == 0 && ok;
+}
+
+void free_recording(ReplayWriter *w) {
+    free(w->data);
+    memset(w, 0, sizeof(*w));
+}
+
+int reserve_bytes(ReplayWriter *w, size_t extra) {
+    if (w->size + extra <= w->capacity) return 1;
+    
+    size_t capacity = w->capacity > 0 ? w->capacity : 256;
+    while (capacity < w->size + extra) {
+        capacity *= 2;
+    }
+    
+    unsigned char *data = realloc(w->data, capacity);
+    if (!data) return 0;
+    
+    w->data = data;
+    w->capacity = capacity;
+    return 1;
+}
+
+int put_varint(ReplayWriter *w, uint32_t value) {
+    if (!reserve_bytes(w, 5)) return 0;
+    
+    while (value >= 0x80) {
+        w->data[w->size++] = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    w->data[w->size++] = (unsigned char)value;
+    return 1;
+}
+
+int get_varint(ReplayPlayer *p, uint32_t *value) {
+    uint32_t result = 0;
+    
+    for (int shift = 0; shift < 35 && p->pos < p->size; shift += 7) {
+        unsigned char byte = p->data[p->pos++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+void put_le(unsigned char *out, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+uint64_t get_le(const unsigned char *in, int bytes) {
+    uint64_t value = 0;
+    
+    for (int i = 0; i < bytes; i++) {
+        value |= (uint64_t)in[i] << (8 * i);
+    }
+    return value;
+}
+
+void write_header(const ReplayHeader *h, unsigned char *out) {
+    put_le(out, REPLAY_MAGIC, 4);
+    put_le(out + 4, REPLAY_VERSION, 2);
+    put_le(out + 6, (uint64_t)h->width, 2);
+    put_le(out + 8, (uint64_t)h->height, 2);
+    put_le(out + 10, 0, 2);
+    put_le(out + 12, h->seed, 8);
+    put_le(out + 20, h->ticks, 4);
+    put_le(out + 24, h->events, 4);
+}
+
+int load_replay(ReplayPlayer *p, const char *path) {
+    memset(p, 0, sizeof(*p));
+    
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    
+    unsigned char *data = NULL;
+    size_t size = 0;
+    if (fseek(f, 0, SEEK_END) == 0) {
+        long end = ftell(f);
+        if (end > 0 && fseek(f, 0, SEEK_SET) == 0) {
+            size = (size_t)end;
+            data = malloc(size);
+        }
+    }
+    
+    int ok = data && fread(data, 1, size, f) == size;
+    fclose(f);
+    
+    if (!ok || !open_replay(p, data, size)) {
+        free(data);
+        memset(p, 0, sizeof(*p));
+        return 0;
+    }
+    
+    p->owns_data = 1;
+    return 1;
+}
+
+int open_replay(ReplayPlayer *p, const void *data, size_t size) {
+    const unsigned char *in = data;
+    
+    memset(p, 0, sizeof(*p));
+    if (size < REPLAY_HEADER_SIZE || get_le(in, 4) != REPLAY_MAGIC || get_le(in + 4, 2) != REPLAY_VERSION) {
+        return 0;
+    }
+    
+    p->header.width = (int)get_le(in + 6, 2);
+    p->header.height = (int)get_le(in + 8, 2);
+    p->header.seed = get_le(in + 12, 8);
+    p->header.ticks = (uint32_t)get_le(in + 20, 4);
+    p->header.events = (uint32_t)get_le(in + 24, 4);
+    p->data = data;
+    p->size = size;
+    p->pos = REPLAY_HEADER_SIZE;
+    next_event(p);
+    return 1;
+}
+
+void free_replay(ReplayPlayer *p) {
+    if (p->owns_data) {
+        free((void *)p->data);
+    }
+    memset(p, 0, sizeof(*p));
+}
+
+void next_event(ReplayPlayer *p) {
+    uint32_t value;
+    
+    if (get_varint(p, &value) && value >> 2 > 0) {
+        p->next_tick = p->tick + (value >> 2);
+        p->next_dir = (int)(value & 3);
+    }
+    else {
+        p->next_tick = 0;
+        p->next_dir = ACTION_NONE;
+    }
+}
+
+void rewind_replay(ReplayPlayer *p, GameState *g) {
+    p->pos = REPLAY_HEADER_SIZE;
+    p->tick = 0;
+    next_event(p);
+    init_game(g, p->header.seed);
+}
+
+int replay_action(ReplayPlayer *p) {
+    int action = ACTION_NONE;
+    
+    p->tick++;
+    if (p->next_dir != ACTION_NONE && p->tick == p->next_tick) {
+        action = p->next_dir;
+        next_event(p);
+    }
+    return action;
+}
+
+GameStatus replay_step(ReplayPlayer *p, GameState *g) {
+    if (g->status != GAME_RUNNING || p->tick >= p->header.ticks) {
+        return (GameStatus)g->status;
+    }
+    
+    return step(g, replay_action(p));
+}
+
+uint32_t seek_replay(ReplayPlayer *p, GameState *g, uint32_t target) {
+    if (target < p->tick) {
+        rewind_replay(p, g);
+    }
+    if (target > p->header.ticks) {
+        target = p->header.ticks;
+    }
+    
+    while (p->tick < target && g->status == GAME_RUNNING) {
+        step(g, replay_action(p));
+    }
+    return p->tick;
+}
\ No newline at end of file
@@ -0,0 +1,55 @@
+#ifndef SNAKE_REPLAY_H
+#define SNAKE_REPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "snake_core.h"
+
+#define REPLAY_MAGIC 0x52504E53u
+#define REPLAY_VERSION 1
+#define REPLAY_HEADER_SIZE 28
+
+typedef struct {
+    uint64_t seed;
+    uint32_t ticks;
+    uint32_t events;
+    int width;
+    int height;
+} ReplayHeader;
+
+typedef struct {
+    ReplayHeader header;
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+    uint32_t last_tick;
+    unsigned char last_dir;
+} ReplayWriter;
+
+typedef struct {
+    ReplayHeader header;
+    const unsigned char *data;
+    size_t size;
+    size_t pos;
+    uint32_t tick;
+    uint32_t next_tick;
+    int next_dir;
+    int owns_data;
+} ReplayPlayer;
+
+int begin_recording(ReplayWriter *w, const GameState *g);
+int restart_recording(ReplayWriter *w, const GameState *g);
+int record_tick(ReplayWriter *w, const GameState *g);
+void seal_recording(ReplayWriter *w);
+int save_replay(ReplayWriter *w, const char *path);
+void free_recording(ReplayWriter *w);
+int load_replay(ReplayPlayer *p, const char *path);
+int open_replay(ReplayPlayer *p, const void *data, size_t size);
+void free_replay(ReplayPlayer *p);
+void rewind_replay(ReplayPlayer *p, GameState *g);
+int replay_action(ReplayPlayer *p);
+GameStatus replay_step(ReplayPlayer *p, GameState *g);
+uint32_t seek_replay(ReplayPlayer *p, GameState *g, uint32_t target);
+
+#endif
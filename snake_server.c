@@ -0,0 +1,429 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_core.h"
+#include "snake_arena.h"
+#include "snake_net.h"
+
+#define MAX_CLIENTS 1024
+#define CLIENT_IN 4096
+#define MAX_BACKLOG (1u << 20)
+#define DEFAULT_SNAKES 64
+#define DEFAULT_TICK_MS 100
+
+typedef struct {
+    int fd;
+    int snake;
+    int joined;
+    int ready;
+    NetBuffer in;
+    NetBuffer out;
+    size_t sent;
+} Client;
+
+typedef struct {
+    Arena arena;
+    int listener;
+    Client *clients;
+    int client_count;
+    NetBuffer delta;
+    struct pollfd *polls;
+    long long delta_bytes;
+    long long sent_bytes;
+    long snapshots;
+    long resyncs;
+} Server;
+
+static volatile sig_atomic_t interrupted;
+
+void on_signal(int sig);
+int64_t now_ns();
+int open_listener(int port);
+int claim_snake(Server *s);
+void accept_clients(Server *s);
+void drop_client(Server *s, int i);
+int send_snapshot(Server *s, Client *c);
+int handle_message(Server *s, Client *c, int type, NetReader *r);
+int read_client(Server *s, Client *c);
+int flush_client(Server *s, Client *c);
+size_t message_length(const NetBuffer *b, size_t start);
+size_t message_start(const Client *c);
+void trim_backlog(Client *c);
+void broadcast_delta(Server *s);
+void poll_clients(Server *s, int timeout);
+void run_server(Server *s, int64_t period, long max_ticks);
+
+int main(int argc, char *argv[]) {
+    int port = NET_DEFAULT_PORT;
+    int width = 128;
+    int height = 128;
+    int snakes = DEFAULT_SNAKES;
+    int food = -1;
+    int tick_ms = DEFAULT_TICK_MS;
+    long max_ticks = 0;
+    uint64_t seed = (uint64_t)time(NULL);
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--snakes") == 0 && i + 1 < argc) {
+            snakes = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--food") == 0 && i + 1 < argc) {
+            food = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--tick-ms") == 0 && i + 1 < argc) {
+            tick_ms = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            max_ticks = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--port N] [--width N] [--height N] [--snakes N] [--food N] [--tick-ms N] [--ticks N] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (snakes < 1 || snakes > ARENA_MAX_SNAKES || tick_ms < 1) {
+        fprintf(stderr, "snakes must be between 1 and %d and the tick at least 1 ms\n", ARENA_MAX_SNAKES);
+        return 1;
+    }
+    
+    Board board;
+    if (!create_board(&board, width, height)) {
+        fprintf(stderr, "board must be between %d and %d cells on each side\n", MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        return 1;
+    }
+    
+    Server server = {0};
+    server.clients = calloc(MAX_CLIENTS, sizeof(Client));
+    server.polls = calloc(MAX_CLIENTS + 1, sizeof(struct pollfd));
+    server.listener = open_listener(port);
+    if (!server.clients || !server.polls || server.listener < 0 ||
+        !create_arena(&server.arena, &board, snakes, food < 0 ? snakes : food, seed)) {
+        fprintf(stderr, "could not start the server on port %d\n", port);
+        return 1;
+    }
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    
+    run_server(&server, (int64_t)tick_ms * 1000000, max_ticks);
+    
+    Arena *a = &server.arena;
+    printf("ticks %u clients %d deaths %ld\n", a->tick, server.client_count, a->deaths);
+    printf("delta %.1f bytes/tick (%.3f per snake) sent %lld bytes snapshots %ld resyncs %ld\n",
+           a->tick ? (double)server.delta_bytes / a->tick : 0.0,
+           a->tick ? (double)server.delta_bytes / a->tick / a->snake_count : 0.0,
+           server.sent_bytes, server.snapshots, server.resyncs);
+    
+    while (server.client_count > 0) {
+        drop_client(&server, server.client_count - 1);
+    }
+    close(server.listener);
+    free_net_buffer(&server.delta);
+    free_arena(a);
+    free(server.polls);
+    free(server.clients);
+    free_board(&board);
+    return 0;
+}
+
+void on_signal(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+int64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int open_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    
+    int on = 1;
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 64) < 0) {
+        close(fd);
+        return -1;
+    }
+    
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+int claim_snake(Server *s) {
+    Arena *a = &s->arena;
+    
+    for (int i = 0; i < a->snake_count; i++) {
+        if (!a->snakes[i].human) {
+            a->snakes[i].human = 1;
+            return i;
+        }
+    }
+    
+    return -1;
+}
+
+void accept_clients(Server *s) {
+    for (;;) {
+        int fd = accept(s->listener, NULL, NULL);
+        if (fd < 0) return;
+        
+        if (s->client_count == MAX_CLIENTS) {
+            close(fd);
+            continue;
+        }
+        
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        
+        Client *c = &s->clients[s->client_count++];
+        memset(c, 0, sizeof(*c));
+        c->fd = fd;
+        c->snake = -1;
+    }
+}
+
+void drop_client(Server *s, int i) {
+    Client *c = &s->clients[i];
+    
+    if (c->snake >= 0) {
+        s->arena.snakes[c->snake].human = 0;
+    }
+    close(c->fd);
+    free_net_buffer(&c->in);
+    free_net_buffer(&c->out);
+    s->clients[i] = s->clients[--s->client_count];
+}
+
+int send_snapshot(Server *s, Client *c) {
+    s->snapshots++;
+    c->ready = encode_snapshot(&c->out, &s->arena);
+    return c->ready;
+}
+
+int handle_message(Server *s, Client *c, int type, NetReader *r) {
+    uint32_t value;
+    
+    if (!net_get_varint(r, &value)) return 0;
+    
+    switch (type) {
+        case NET_HELLO:
+            if (value != NET_VERSION || c->joined) return 0;
+            
+            c->snake = claim_snake(s);
+            if (c->snake < 0) return 0;
+            
+            c->joined = 1;
+            return put_message(&c->out, NET_WELCOME, (uint32_t)c->snake) && send_snapshot(s, c);
+        case NET_TURN:
+            if (c->snake < 0 || value > RIGHT) return 0;
+            
+            steer_snake(&s->arena, c->snake, (Direction)value);
+            return 1;
+        case NET_WATCH:
+            if (value != NET_VERSION || c->joined) return 0;
+            
+            c->joined = 1;
+            return send_snapshot(s, c);
+        case NET_RESYNC:
+            if (!c->joined) return 0;
+            
+            s->resyncs++;
+            trim_backlog(c);
+            return send_snapshot(s, c);
+        default:
+            return 0;
+    }
+}
+
+int read_client(Server *s, Client *c) {
+    if (!net_reserve(&c->in, CLIENT_IN - c->in.size)) return 0;
+    
+    while (c->in.size < CLIENT_IN) {
+        ssize_t got = recv(c->fd, c->in.data + c->in.size, CLIENT_IN - c->in.size, 0);
+        if (got == 0) return 0;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            break;
+        }
+        c->in.size += (size_t)got;
+    }
+    
+    size_t pos = 0;
+    for (;;) {
+        int type;
+        NetReader payload;
+        long used = next_message(c->in.data + pos, c->in.size - pos, &type, &payload);
+        if (used < 0) return 0;
+        if (used == 0) break;
+        
+        if (!handle_message(s, c, type, &payload)) return 0;
+        pos += (size_t)used;
+    }
+    
+    if (pos == 0 && c->in.size == CLIENT_IN) return 0;
+    
+    memmove(c->in.data, c->in.data + pos, c->in.size - pos);
+    c->in.size -= pos;
+    return 1;
+}
+
+int flush_client(Server *s, Client *c) {
+    while (c->sent < c->out.size) {
+        ssize_t put = send(c->fd, c->out.data + c->sent, c->out.size - c->sent, MSG_NOSIGNAL);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            
+            size_t start = message_start(c);
+            memmove(c->out.data, c->out.data + start, c->out.size - start);
+            c->out.size -= start;
+            c->sent -= start;
+            return 1;
+        }
+        c->sent += (size_t)put;
+        s->sent_bytes += put;
+    }
+    
+    c->out.size = 0;
+    c->sent = 0;
+    return 1;
+}
+
+size_t message_length(const NetBuffer *b, size_t start) {
+    const unsigned char *p = b->data + start;
+    
+    return NET_HEADER_SIZE + ((size_t)p[0] | (size_t)p[1] << 8 | (size_t)p[2] << 16 | (size_t)p[3] << 24);
+}
+
+size_t message_start(const Client *c) {
+    size_t start = 0;
+    
+    while (start < c->sent && start + message_length(&c->out, start) <= c->sent) {
+        start += message_length(&c->out, start);
+    }
+    
+    return start;
+}
+
+void trim_backlog(Client *c) {
+    size_t start = message_start(c);
+    
+    c->out.size = start < c->sent ? start + message_length(&c->out, start) : start;
+}
+
+void broadcast_delta(Server *s) {
+    s->delta.size = 0;
+    if (!encode_delta(&s->delta, &s->arena)) return;
+    
+    s->delta_bytes += (long long)s->delta.size;
+    for (int i = 0; i < s->client_count; i++) {
+        Client *c = &s->clients[i];
+        if (!c->ready) continue;
+        
+        if (c->out.size - c->sent > MAX_BACKLOG) {
+            s->resyncs++;
+            trim_backlog(c);
+            send_snapshot(s, c);
+        }
+        else if (net_reserve(&c->out, s->delta.size)) {
+            memcpy(c->out.data + c->out.size, s->delta.data, s->delta.size);
+            c->out.size += s->delta.size;
+        }
+    }
+}
+
+void poll_clients(Server *s, int timeout) {
+    struct pollfd *polls = s->polls;
+    int count = s->client_count;
+    
+    polls[0].fd = s->listener;
+    polls[0].events = POLLIN;
+    for (int i = 0; i < count; i++) {
+        Client *c = &s->clients[i];
+        polls[i + 1].fd = c->fd;
+        polls[i + 1].events = (short)(POLLIN | (c->sent < c->out.size ? POLLOUT : 0));
+    }
+    
+    if (poll(polls, (nfds_t)count + 1, timeout) <= 0) return;
+    
+    for (int i = count - 1; i >= 0; i--) {
+        short events = polls[i + 1].revents;
+        Client *c = &s->clients[i];
+        if (!events) continue;
+        
+        int ok = !(events & (POLLERR | POLLNVAL));
+        if (ok && (events & (POLLIN | POLLHUP))) {
+            ok = read_client(s, c);
+        }
+        if (ok && c->sent < c->out.size) {
+            ok = flush_client(s, c);
+        }
+        if (!ok) {
+            drop_client(s, i);
+        }
+    }
+    
+    if (polls[0].revents & POLLIN) {
+        accept_clients(s);
+    }
+}
+
+void run_server(Server *s, int64_t period, long max_ticks) {
+    int64_t next_tick = now_ns() + period;
+    
+    while (!interrupted && (max_ticks == 0 || s->arena.tick < (uint32_t)max_ticks)) {
+        int64_t remaining = next_tick - now_ns();
+        poll_clients(s, remaining > 0 ? (int)((remaining + 999999) / 1000000) : 0);
+        if (now_ns() < next_tick) continue;
+        
+        plan_arena(&s->arena);
+        step_arena(&s->arena);
+        broadcast_delta(s);
+        for (int i = s->client_count - 1; i >= 0; i--) {
+            if (!flush_client(s, &s->clients[i])) {
+                drop_client(s, i);
+            }
+        }
+        next_tick += period;
+    }
+}
@@ -0,0 +1,516 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_core.h"
+#include "snake_net.h"
+#include "snake_pool.h"
+#include "snake_wheel.h"
+#include "snake_workers.h"
+
+#define DEFAULT_SESSIONS 4096
+#define SESSION_IN 256
+#define SESSION_OUT 4096
+#define EVENT_BATCH 256
+#define WHEEL_RESOLUTION 1000000
+#define IDLE_WAIT_MS 100
+#define LISTENER_ID UINT32_MAX
+#define MAX_SESSIONS_PER_WORKER (1 << 20)
+
+typedef struct {
+    int fd;
+    int next_free;
+    int waiting;
+    uint32_t tick;
+    long games;
+    GameState *game;
+    NetBuffer in;
+    NetBuffer out;
+    size_t sent;
+} Session;
+
+typedef struct {
+    pthread_t thread;
+    int epoll;
+    int listener;
+    int listening;
+    const Board *board;
+    Session *sessions;
+    int capacity;
+    int free_head;
+    int active;
+    int peak;
+    GamePool pool;
+    TimerWheel wheel;
+    Rng rng;
+    atomic_int *stop;
+    long long ticks;
+    long long sent_bytes;
+    long games;
+    long accepted;
+    long rejected;
+    long dropped;
+} Worker;
+
+static atomic_int stopping;
+
+void on_signal(int sig);
+int64_t now_ns();
+int open_listener(int port);
+size_t session_footprint(const Board *b);
+int create_worker(Worker *w, const Board *b, int capacity, int listener, uint64_t seed);
+void free_worker(Worker *w);
+void start_session_game(Worker *w, Session *s, int64_t now);
+int watch_listener(Worker *w, int on);
+void accept_sessions(Worker *w);
+void close_session(Worker *w, int id);
+int flush_session(Worker *w, Session *s);
+int read_session(Worker *w, Session *s);
+void tick_session(void *context, int id, int64_t due);
+void *session_worker(void *context);
+
+int main(int argc, char *argv[]) {
+    int port = NET_SESSION_PORT;
+    int width = DEFAULT_WIDTH;
+    int height = DEFAULT_HEIGHT;
+    int sessions = DEFAULT_SESSIONS;
+    int threads = 0;
+    long seconds = 0;
+    uint64_t seed = (uint64_t)time(NULL);
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) {
+            sessions = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else {
+            fprintf(stderr, "usage: %s [--port N] [--width N] [--height N] [--sessions N] [--threads N] [--seconds N] [--seed N]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    if (threads < 1) threads = hardware_threads();
+    if (sessions < threads) sessions = threads;
+    if (sessions / threads > MAX_SESSIONS_PER_WORKER) {
+        fprintf(stderr, "at most %d sessions per thread\n", MAX_SESSIONS_PER_WORKER);
+        return 1;
+    }
+    
+    Board board;
+    if (!create_board(&board, width, height)) {
+        fprintf(stderr, "board must be between %d and %d cells on each side\n", MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        return 1;
+    }
+    
+    int listener = open_listener(port);
+    Worker *workers = calloc((size_t)threads, sizeof(Worker));
+    if (listener < 0 || !workers) {
+        fprintf(stderr, "could not listen on port %d\n", port);
+        return 1;
+    }
+    
+    int started = 0;
+    for (; started < threads; started++) {
+        Worker *w = &workers[started];
+        int capacity = sessions / threads + (started < sessions % threads);
+        if (!create_worker(w, &board, capacity, listener, seed + (uint64_t)started * 0x9E3779B97F4A7C15ull)) break;
+        
+        w->stop = &stopping;
+        if (pthread_create(&w->thread, NULL, session_worker, w) != 0) {
+            free_worker(w);
+            break;
+        }
+    }
+    
+    if (started < threads) {
+        fprintf(stderr, "could not start %d workers for %d sessions\n", threads, sessions);
+        atomic_store(&stopping, 1);
+    }
+    else {
+        printf("%d sessions on %d threads, at most %zu bytes per session\n",
+               sessions, threads, session_footprint(&board));
+        fflush(stdout);
+    }
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    
+    int64_t start = now_ns();
+    while (!atomic_load(&stopping)) {
+        struct timespec pause = {0, IDLE_WAIT_MS * 1000000L};
+        nanosleep(&pause, NULL);
+        if (seconds > 0 && now_ns() - start >= (int64_t)seconds * 1000000000) {
+            atomic_store(&stopping, 1);
+        }
+    }
+    
+    Worker total = {0};
+    for (int i = 0; i < started; i++) {
+        Worker *w = &workers[i];
+        pthread_join(w->thread, NULL);
+        total.ticks += w->ticks;
+        total.sent_bytes += w->sent_bytes;
+        total.games += w->games;
+        total.accepted += w->accepted;
+        total.rejected += w->rejected;
+        total.dropped += w->dropped;
+        total.peak += w->peak;
+        free_worker(w);
+    }
+    
+    double elapsed = (double)(now_ns() - start) / 1e9;
+    printf("accepted %ld rejected %ld dropped %ld peak %d sessions\n",
+           total.accepted, total.rejected, total.dropped, total.peak);
+    printf("ticks %lld (%.0f/s) games %ld sent %lld bytes\n",
+           total.ticks, elapsed > 0 ? (double)total.ticks / elapsed : 0.0, total.games, total.sent_bytes);
+    
+    close(listener);
+    free(workers);
+    free_board(&board);
+    return started == threads ? 0 : 1;
+}
+
+void on_signal(int sig) {
+    (void)sig;
+    atomic_store(&stopping, 1);
+}
+
+int64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int open_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    
+    int on = 1;
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(fd, (struct sockaddr *)&address, sizeof(address)) < 0 || listen(fd, 1024) < 0) {
+        close(fd);
+        return -1;
+    }
+    
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+size_t session_footprint(const Board *b) {
+    return sizeof(Session) + sizeof(WheelTimer) + SESSION_IN + SESSION_OUT + pooled_game_size(b);
+}
+
+int create_worker(Worker *w, const Board *b, int capacity, int listener, uint64_t seed) {
+    memset(w, 0, sizeof(*w));
+    w->board = b;
+    w->listener = listener;
+    w->capacity = capacity;
+    w->epoll = epoll_create1(0);
+    w->sessions = calloc((size_t)capacity, sizeof(Session));
+    rng_seed(&w->rng, seed);
+    init_game_pool(&w->pool, b, 0);
+    if (w->epoll < 0 || !w->sessions || !create_wheel(&w->wheel, capacity, WHEEL_RESOLUTION, now_ns())) {
+        free_worker(w);
+        return 0;
+    }
+    
+    for (int i = 0; i < capacity; i++) {
+        Session *s = &w->sessions[i];
+        s->fd = -1;
+        s->next_free = i + 1 < capacity ? i + 1 : -1;
+        if (!net_reserve(&s->in, SESSION_IN) || !net_reserve(&s->out, SESSION_OUT)) {
+            w->capacity = i + 1;
+            free_worker(w);
+            return 0;
+        }
+    }
+    
+    if (!watch_listener(w, 1)) {
+        free_worker(w);
+        return 0;
+    }
+    return 1;
+}
+
+int watch_listener(Worker *w, int on) {
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLEXCLUSIVE;
+    event.data.u64 = LISTENER_ID;
+    if (epoll_ctl(w->epoll, on ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, w->listener, &event) < 0) return 0;
+    
+    w->listening = on;
+    return 1;
+}
+
+void free_worker(Worker *w) {
+    for (int i = 0; w->sessions && i < w->capacity; i++) {
+        Session *s = &w->sessions[i];
+        if (s->fd >= 0) {
+            close(s->fd);
+        }
+        free_net_buffer(&s->in);
+        free_net_buffer(&s->out);
+    }
+    
+    if (w->epoll >= 0) {
+        close(w->epoll);
+    }
+    free(w->sessions);
+    free_game_pool(&w->pool);
+    free_wheel(&w->wheel);
+    memset(w, 0, sizeof(*w));
+}
+
+void start_session_game(Worker *w, Session *s, int64_t now) {
+    uint64_t seed = (uint64_t)rng_next(&w->rng) << 32 | rng_next(&w->rng);
+    
+    init_game(s->game, seed);
+    s->tick = 0;
+    put_start(&s->out, s->game);
+    schedule_timer(&w->wheel, (int)(s - w->sessions), now + (int64_t)tick_period_ms(s->game) * 1000000);
+}
+
+void accept_sessions(Worker *w) {
+    while (w->free_head >= 0) {
+        int fd = accept(w->listener, NULL, NULL);
+        if (fd < 0) return;
+        
+        int id = w->free_head;
+        Session *s = &w->sessions[id];
+        int on = 1;
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = (uint64_t)id;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        if (epoll_ctl(w->epoll, EPOLL_CTL_ADD, fd, &event) < 0) {
+            w->rejected++;
+            close(fd);
+            continue;
+        }
+        
+        w->free_head = s->next_free;
+        s->fd = fd;
+        s->waiting = 0;
+        s->games = 0;
+        s->in.size = 0;
+        s->out.size = 0;
+        s->sent = 0;
+        w->accepted++;
+        if (++w->active > w->peak) {
+            w->peak = w->active;
+        }
+    }
+    
+    watch_listener(w, 0);
+}
+
+void close_session(Worker *w, int id) {
+    Session *s = &w->sessions[id];
+    
+    cancel_timer(&w->wheel, id);
+    if (s->game) {
+        release_game(&w->pool, s->game);
+        s->game = NULL;
+    }
+    close(s->fd);
+    s->fd = -1;
+    s->next_free = w->free_head;
+    w->free_head = id;
+    w->active--;
+    if (!w->listening) {
+        watch_listener(w, 1);
+    }
+}
+
+int flush_session(Worker *w, Session *s) {
+    while (s->sent < s->out.size) {
+        ssize_t put = send(s->fd, s->out.data + s->sent, s->out.size - s->sent, MSG_NOSIGNAL);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            
+            memmove(s->out.data, s->out.data + s->sent, s->out.size - s->sent);
+            s->out.size -= s->sent;
+            s->sent = 0;
+            if (!s->waiting) {
+                struct epoll_event event;
+                event.events = EPOLLIN | EPOLLOUT;
+                event.data.u64 = (uint64_t)(s - w->sessions);
+                epoll_ctl(w->epoll, EPOLL_CTL_MOD, s->fd, &event);
+                s->waiting = 1;
+            }
+            return 1;
+        }
+        s->sent += (size_t)put;
+        w->sent_bytes += put;
+    }
+    
+    s->out.size = 0;
+    s->sent = 0;
+    if (s->waiting) {
+        struct epoll_event event;
+        event.events = EPOLLIN;
+        event.data.u64 = (uint64_t)(s - w->sessions);
+        epoll_ctl(w->epoll, EPOLL_CTL_MOD, s->fd, &event);
+        s->waiting = 0;
+    }
+    return 1;
+}
+
+int read_session(Worker *w, Session *s) {
+    while (s->in.size < s->in.capacity) {
+        ssize_t got = recv(s->fd, s->in.data + s->in.size, s->in.capacity - s->in.size, 0);
+        if (got == 0) return 0;
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) return 0;
+            break;
+        }
+        s->in.size += (size_t)got;
+    }
+    
+    size_t pos = 0;
+    for (;;) {
+        int type;
+        uint32_t value;
+        NetReader payload;
+        long used = next_message(s->in.data + pos, s->in.size - pos, &type, &payload);
+        if (used < 0) return 0;
+        if (used == 0) break;
+        
+        pos += (size_t)used;
+        if (!net_get_varint(&payload, &value)) return 0;
+        
+        if (type == NET_HELLO) {
+            if (value != NET_VERSION || s->game) return 0;
+            
+            s->game = acquire_game(&w->pool);
+            if (!s->game) return 0;
+            
+            s->games = 1;
+            start_session_game(w, s, now_ns());
+        }
+        else if (type == NET_TURN && s->game && value <= RIGHT) {
+            queue_turn(s->game, (Direction)value);
+        }
+        else {
+            return 0;
+        }
+    }
+    
+    if (pos == 0 && s->in.size == s->in.capacity) return 0;
+    
+    memmove(s->in.data, s->in.data + pos, s->in.size - pos);
+    s->in.size -= pos;
+    return flush_session(w, s);
+}
+
+void tick_session(void *context, int id, int64_t due) {
+    Worker *w = context;
+    Session *s = &w->sessions[id];
+    
+    if (s->out.capacity - s->out.size < NET_TICK_MAX + NET_START_MAX) {
+        w->dropped++;
+        close_session(w, id);
+        return;
+    }
+    
+    GameStatus status = step(s->game, ACTION_NONE);
+    put_tick(&s->out, ++s->tick, s->game);
+    w->ticks++;
+    if (status != GAME_RUNNING) {
+        w->games++;
+        s->games++;
+        start_session_game(w, s, due);
+    }
+    else {
+        schedule_timer(&w->wheel, id, due + (int64_t)tick_period_ms(s->game) * 1000000);
+    }
+    
+    if (!flush_session(w, s)) {
+        close_session(w, id);
+    }
+}
+
+void *session_worker(void *context) {
+    Worker *w = context;
+    struct epoll_event events[EVENT_BATCH];
+    
+    while (!atomic_load(w->stop)) {
+        int64_t now = now_ns();
+        int64_t expiry = next_expiry(&w->wheel);
+        int timeout = IDLE_WAIT_MS;
+        if (expiry >= 0) {
+            int64_t wait = (expiry - now + 999999) / 1000000;
+            timeout = wait < 0 ? 0 : wait < IDLE_WAIT_MS ? (int)wait : IDLE_WAIT_MS;
+        }
+        
+        int count = epoll_wait(w->epoll, events, EVENT_BATCH, timeout);
+        for (int i = 0; i < count; i++) {
+            if (events[i].data.u64 == LISTENER_ID) {
+                accept_sessions(w);
+                continue;
+            }
+            
+            int id = (int)events[i].data.u64;
+            Session *s = &w->sessions[id];
+            if (s->fd < 0) continue;
+            
+            int ok = !(events[i].events & EPOLLERR);
+            if (ok && (events[i].events & (EPOLLIN | EPOLLHUP))) {
+                ok = read_session(w, s);
+            }
+            if (ok && (events[i].events & EPOLLOUT)) {
+                ok = flush_session(w, s);
+            }
+            if (!ok) {
+                close_session(w, id);
+            }
+        }
+        
+        advance_wheel(&w->wheel, now_ns(), tick_session, w);
+    }
+    
+    return NULL;
+}
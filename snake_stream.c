@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_stream.h"
+
+void stream_sink_frame(void *context, const char *text, int length);
+void stream_sink_text(void *context, int x, int y, const char *text, int length);
+int reserve_out(StreamWriter *s, size_t extra);
+void out_byte(StreamWriter *s, unsigned char value);
+void out_varint(StreamWriter *s, uint32_t value);
+void out_token(StreamWriter *s, uint32_t count, StreamOp op);
+int cell_changed(const StreamWriter *s, int key, int i);
+void encode_span(StreamWriter *s, int start, int end);
+int encode_frame(StreamWriter *s, int key);
+int varint_size(uint32_t value);
+int file_varint(FILE *f, uint32_t *value);
+int frame_varint(StreamReader *r, size_t *pos, uint32_t *value);
+
+int open_stream(StreamWriter *s, FILE *file, const View *v, int key_interval) {
+    memset(s, 0, sizeof(*s));
+    s->file = file;
+    s->columns = v->status_width > v->screen_width ? v->status_width : v->screen_width;
+    s->rows = v->view_height + 3;
+    s->key_interval = key_interval > 0 ? key_interval : STREAM_KEY_INTERVAL;
+    
+    size_t cells = (size_t)s->columns * s->rows;
+    s->shown = malloc(cells);
+    s->next = malloc(cells);
+    if (!s->shown || !s->next || !reserve_out(s, cells * 2 + 64)) {
+        close_stream(s);
+        return 0;
+    }
+    
+    memset(s->shown, ' ', cells);
+    memset(s->next, ' ', cells);
+    for (int i = 0; i < 4; i++) {
+        out_byte(s, (unsigned char)(STREAM_MAGIC >> (8 * i)));
+    }
+    out_byte(s, STREAM_VERSION);
+    out_varint(s, (uint32_t)s->columns);
+    out_varint(s, (uint32_t)s->rows);
+    
+    int ok = fwrite(s->out, 1, s->out_size, file) == s->out_size;
+    s->bytes += (long long)s->out_size;
+    s->out_size = 0;
+    return ok;
+}
+
+void close_stream(StreamWriter *s) {
+    if (s->file) {
+        fflush(s->file);
+    }
+    free(s->shown);
+    free(s->next);
+    free(s->out);
+    memset(s, 0, sizeof(*s));
+}
+
+ViewSink stream_sink(StreamWriter *s) {
+    ViewSink sink = {s, stream_sink_frame, stream_sink_text};
+    return sink;
+}
+
+void stream_sink_frame(void *context, const char *text, int length) {
+    stream_frame_text(context, text, length);
+}
+
+void stream_sink_text(void *context, int x, int y, const char *text, int length) {
+    stream_text(context, x, y, text, length);
+}
+
+void stream_frame_text(StreamWriter *s, const char *text, int length) {
+    int x = 0;
+    int y = 0;
+    
+    memset(s->next, ' ', (size_t)s->columns * s->rows);
+    for (int i = 0; i < length; i++) {
+        if (text[i] == '\n') {
+            x = 0;
+            y++;
+            continue;
+        }
+        
+        if (x < s->columns && y < s->rows) {
+            s->next[y * s->columns + x] = text[i];
+        }
+        x++;
+    }
+}
+
+void stream_text(StreamWriter *s, int x, int y, const char *text, int length) {
+    if (y < 0 || y >= s->rows || x < 0 || x >= s->columns) return;
+    
+    if (length > s->columns - x) {
+        length = s->columns - x;
+    }
+    memcpy(&s->next[y * s->columns + x], text, (size_t)length);
+}
+
+int reserve_out(StreamWriter *s, size_t extra) {
+    if (s->out_size + extra <= s->out_capacity) return 1;
+    
+    size_t capacity = s->out_capacity > 0 ? s->out_capacity : 256;
+    while (capacity < s->out_size + extra) {
+        capacity *= 2;
+    }
+    
+    unsigned char *out = realloc(s->out, capacity);
+    if (!out) return 0;
+    
+    s->out = out;
+    s->out_capacity = capacity;
+    return 1;
+}
+
+void out_byte(StreamWriter *s, unsigned char value) {
+    s->out[s->out_size++] = value;
+}
+
+void out_varint(StreamWriter *s, uint32_t value) {
+    while (value >= 0x80) {
+        out_byte(s, (unsigned char)(value | 0x80));
+        value >>= 7;
+    }
+    out_byte(s, (unsigned char)value);
+}
+
+void out_token(StreamWriter *s, uint32_t count, StreamOp op) {
+    out_varint(s, count << 2 | op);
+}
+
+int cell_changed(const StreamWriter *s, int key, int i) {
+    return s->next[i] != (key ? ' ' : s->shown[i]);
+}
+
+void encode_span(StreamWriter *s, int start, int end) {
+    const char *next = s->next;
+    
+    for (int i = start; i < end;) {
+        int run = 1;
+        while (i + run < end && next[i + run] == next[i]) {
+            run++;
+        }
+        
+        if (run >= STREAM_MIN_REPEAT) {
+            out_token(s, (uint32_t)run, STREAM_REPEAT);
+            out_byte(s, (unsigned char)next[i]);
+            i += run;
+            continue;
+        }
+        
+        int j = i + run;
+        while (j < end) {
+            int ahead = 1;
+            while (j + ahead < end && ahead < STREAM_MIN_REPEAT && next[j + ahead] == next[j]) {
+                ahead++;
+            }
+            if (ahead >= STREAM_MIN_REPEAT) break;
+            j += ahead;
+        }
+        
+        out_token(s, (uint32_t)(j - i), STREAM_LITERAL);
+        memcpy(&s->out[s->out_size], &next[i], (size_t)(j - i));
+        s->out_size += (size_t)(j - i);
+        i = j;
+    }
+}
+
+int encode_frame(StreamWriter *s, int key) {
+    int cells = s->columns * s->rows;
+    int skip = 0;
+    int changed = 0;
+    
+    for (int pos = 0; pos < cells;) {
+        if (!cell_changed(s, key, pos)) {
+            skip++;
+            pos++;
+            continue;
+        }
+        
+        int last = pos;
+        for (int i = pos + 1; i < cells && i - last <= STREAM_MERGE_GAP; i++) {
+            if (cell_changed(s, key, i)) last = i;
+        }
+        
+        if (skip > 0) {
+            out_token(s, (uint32_t)skip, STREAM_SKIP);
+            skip = 0;
+        }
+        encode_span(s, pos, last + 1);
+        changed = 1;
+        pos = last + 1;
+    }
+    
+    return changed;
+}
+
+int emit_frame(StreamWriter *s, uint32_t elapsed_ms) {
+    int cells = s->columns * s->rows;
+    int key = s->frames % s->key_interval == 0;
+    
+    s->pending_ms += elapsed_ms;
+    if (!key && memcmp(s->shown, s->next, (size_t)cells) == 0) return 1;
+    
+    s->out_size = 0;
+    if (!reserve_out(s, (size_t)cells * 3 + 16)) return 0;
+    
+    out_byte(s, (unsigned char)key);
+    out_varint(s, s->pending_ms);
+    encode_frame(s, key);
+    memcpy(s->shown, s->next, (size_t)cells);
+    
+    uint32_t length = (uint32_t)s->out_size;
+    out_varint(s, length);
+    
+    int ok = fwrite(&s->out[length], 1, s->out_size - length, s->file) == s->out_size - length &&
+             fwrite(s->out, 1, length, s->file) == length && fflush(s->file) == 0;
+    s->bytes += (long long)s->out_size;
+    s->frames++;
+    s->keys += key;
+    s->pending_ms = 0;
+    return ok;
+}
+
+int varint_size(uint32_t value) {
+    int size = 1;
+    
+    while (value >= 0x80) {
+        value >>= 7;
+        size++;
+    }
+    return size;
+}
+
+int file_varint(FILE *f, uint32_t *value) {
+    uint32_t result = 0;
+    
+    for (int shift = 0; shift < 35; shift += 7) {
+        int byte = getc(f);
+        if (byte == EOF) return 0;
+        
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+int open_stream_reader(StreamReader *r, FILE *file) {
+    unsigned char magic[5];
+    uint32_t columns;
+    uint32_t rows;
+    
+    memset(r, 0, sizeof(*r));
+    r->file = file;
+    if (fread(magic, 1, sizeof(magic), file) != sizeof(magic)) return 0;
+    if (((uint32_t)magic[0] | (uint32_t)magic[1] << 8 | (uint32_t)magic[2] << 16 | (uint32_t)magic[3] << 24) != STREAM_MAGIC ||
+        magic[4] != STREAM_VERSION) return 0;
+    if (!file_varint(file, &columns) || !file_varint(file, &rows)) return 0;
+    if (columns == 0 || rows == 0 || (uint64_t)columns * rows > STREAM_MAX_FRAME) return 0;
+    
+    r->columns = (int)columns;
+    r->rows = (int)rows;
+    r->screen = malloc((size_t)columns * rows);
+    if (!r->screen) return 0;
+    
+    memset(r->screen, ' ', (size_t)columns * rows);
+    r->bytes = (long long)sizeof(magic) + varint_size(columns) + varint_size(rows);
+    return 1;
+}
+
+void close_stream_reader(StreamReader *r) {
+    free(r->screen);
+    free(r->frame);
+    memset(r, 0, sizeof(*r));
+}
+
+int frame_varint(StreamReader *r, size_t *pos, uint32_t *value) {
+    uint32_t result = 0;
+    
+    for (int shift = 0; shift < 35 && *pos < r->frame_size; shift += 7) {
+        unsigned char byte = r->frame[(*pos)++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+int read_stream_frame(StreamReader *r, uint32_t *elapsed_ms, int *key) {
+    uint32_t length;
+    
+    if (!file_varint(r->file, &length) || length < 2 || length > STREAM_MAX_FRAME) return 0;
+    if (length > r->frame_capacity) {
+        unsigned char *frame = realloc(r->frame, length);
+        if (!frame) return 0;
+        
+        r->frame = frame;
+        r->frame_capacity = length;
+    }
+    if (fread(r->frame, 1, length, r->file) != length) return 0;
+    
+    size_t pos = 1;
+    size_t cells = (size_t)r->columns * r->rows;
+    size_t cursor = 0;
+    r->frame_size = length;
+    *key = r->frame[0] != 0;
+    if (!frame_varint(r, &pos, elapsed_ms)) return 0;
+    if (*key) {
+        memset(r->screen, ' ', cells);
+    }
+    
+    while (pos < r->frame_size) {
+        uint32_t token;
+        if (!frame_varint(r, &pos, &token)) return 0;
+        
+        size_t count = token >> 2;
+        if (count > cells - cursor) return 0;
+        
+        switch ((StreamOp)(token & 3)) {
+            case STREAM_SKIP:
+                break;
+            case STREAM_LITERAL:
+                if (count > r->frame_size - pos) return 0;
+                
+                memcpy(&r->screen[cursor], &r->frame[pos], count);
+                pos += count;
+                break;
+            case STREAM_REPEAT:
+                if (pos >= r->frame_size) return 0;
+                
+                memset(&r->screen[cursor], r->frame[pos++], count);
+                break;
+            default:
+                return 0;
+        }
+        cursor += count;
+    }
+    
+    r->frames++;
+    r->keys += *key;
+    r->bytes += (long long)length + varint_size(length);
+    return 1;
+}
@@ -0,0 +1,62 @@
+#ifndef SNAKE_STREAM_H
+#define SNAKE_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "snake_view.h"
+
+#define STREAM_MAGIC 0x534B4E53u
+#define STREAM_VERSION 1
+#define STREAM_KEY_INTERVAL 256
+#define STREAM_MERGE_GAP 2
+#define STREAM_MIN_REPEAT 3
+#define STREAM_MAX_FRAME (16u << 20)
+
+typedef enum {
+    STREAM_SKIP,
+    STREAM_LITERAL,
+    STREAM_REPEAT
+} StreamOp;
+
+typedef struct {
+    FILE *file;
+    int columns;
+    int rows;
+    int key_interval;
+    char *shown;
+    char *next;
+    unsigned char *out;
+    size_t out_size;
+    size_t out_capacity;
+    uint32_t pending_ms;
+    long frames;
+    long keys;
+    long long bytes;
+} StreamWriter;
+
+typedef struct {
+    FILE *file;
+    int columns;
+    int rows;
+    char *screen;
+    unsigned char *frame;
+    size_t frame_size;
+    size_t frame_capacity;
+    long frames;
+    long keys;
+    long long bytes;
+} StreamReader;
+
+int open_stream(StreamWriter *s, FILE *file, const View *v, int key_interval);
+void close_stream(StreamWriter *s);
+ViewSink stream_sink(StreamWriter *s);
+void stream_frame_text(StreamWriter *s, const char *text, int length);
+void stream_text(StreamWriter *s, int x, int y, const char *text, int length);
+int emit_frame(StreamWriter *s, uint32_t elapsed_ms);
+int open_stream_reader(StreamReader *r, FILE *file);
+void close_stream_reader(StreamReader *r);
+int read_stream_frame(StreamReader *r, uint32_t *elapsed_ms, int *key);
+
+#endif
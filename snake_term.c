@@ -0,0 +1,521 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "snake_core.h"
+#include "snake_autopilot.h"
+#include "snake_pipeline.h"
+#include "snake_replay.h"
+#include "snake_stream.h"
+#include "snake_view.h"
+
+#define MAX_CATCH_UP_TICKS 4
+#define INPUT_BATCH 64
+#define ESCAPE_LENGTH 2
+#define ESCAPE_TIMEOUT_MS 50
+#define CURSOR_MAX 16
+#define SYNC_BEGIN "\x1b[?2026h"
+#define SYNC_END "\x1b[?2026l"
+#define CLEAR_LINE "\x1b[K"
+#define ENTER_SCREEN "\x1b[?1049h\x1b[?25l\x1b[2J"
+#define LEAVE_SCREEN "\x1b[?25h\x1b[?1049l"
+
+typedef struct {
+    int input;
+    int output;
+    struct termios saved;
+    int raw;
+    int full_frames;
+    int changed;
+    View view;
+    char *out;
+    size_t out_length;
+    size_t out_capacity;
+    Autopilot *autopilot;
+    ReplayPlayer *replay;
+    ReplayWriter *recorder;
+    StreamWriter *stream;
+    int64_t streamed_at;
+    unsigned char escape[ESCAPE_LENGTH];
+    int escape_length;
+    int64_t escape_deadline;
+} Terminal;
+
+static volatile sig_atomic_t interrupted;
+
+void on_signal(int sig);
+int setup_terminal(Terminal *t, const Board *b);
+void restore_terminal(Terminal *t);
+void append(Terminal *t, const char *text, size_t length);
+void append_cursor(Terminal *t, int x, int y);
+void term_frame(void *context, const char *text, int length);
+void term_text(void *context, int x, int y, const char *text, int length);
+int flush_output(Terminal *t);
+void draw_game(Terminal *t, GameState *g);
+void stream_frame(Terminal *t);
+void handle_key(Terminal *t, GameState *g, int command);
+void read_input(Terminal *t, GameState *g);
+void expire_escape(Terminal *t, GameState *g);
+int64_t now_ns();
+int64_t tick_period(GameState *g);
+void wait_input(Terminal *t, GameState *g, int64_t deadline);
+int replay_done(Terminal *t);
+void advance_game(Terminal *t, GameState *g);
+void game_loop(Terminal *t, GameState *g);
+
+int main(int argc, char *argv[]) {
+    Board board;
+    GameState game;
+    Terminal terminal = {0};
+    Autopilot autopilot;
+    AutopilotMode mode = AUTOPILOT_PATH;
+    int use_autopilot = 0;
+    ReplayPlayer replay;
+    ReplayWriter recorder;
+    StreamWriter stream;
+    FILE *stream_file = NULL;
+    const char *record_path = NULL;
+    const char *stream_path = NULL;
+    const char *replay_path = NULL;
+    long seek = 0;
+    
+    uint64_t seed = (uint64_t)time(NULL);
+    int width = DEFAULT_WIDTH;
+    int height = DEFAULT_HEIGHT;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--full") == 0) {
+            terminal.full_frames = 1;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--autopilot") == 0 && i + 1 < argc) {
+            if (!parse_autopilot_mode(argv[++i], &mode)) {
+                printf("Unknown autopilot mode '%s'; use path or cycle.\n", argv[i]);
+                return 1;
+            }
+            use_autopilot = 1;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            seek = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--stream") == 0 && i + 1 < argc) {
+            stream_path = argv[++i];
+        }
+    }
+    
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) {
+        printf("Snake needs a terminal on stdin and stdout.\n");
+        return 1;
+    }
+    
+    if (replay_path) {
+        if (!load_replay(&replay, replay_path)) {
+            printf("Could not read replay '%s'.\n", replay_path);
+            return 1;
+        }
+        terminal.replay = &replay;
+        width = replay.header.width;
+        height = replay.header.height;
+        use_autopilot = 0;
+        record_path = NULL;
+    }
+    
+    if (!create_board(&board, width, height)) {
+        printf("The board must be between %d and %d cells on each side.\n", MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        return 1;
+    }
+    if (!create_game(&game, &board, NULL) || !setup_terminal(&terminal, &board)) {
+        restore_terminal(&terminal);
+        printf("Not enough memory for a %d x %d board.\n", width, height);
+        return 1;
+    }
+    if (use_autopilot) {
+        if (!create_autopilot(&autopilot, &board, mode)) {
+            restore_terminal(&terminal);
+            printf("Not enough memory for the autopilot.\n");
+            return 1;
+        }
+        terminal.autopilot = &autopilot;
+    }
+    
+    init_game(&game, seed);
+    if (terminal.autopilot) {
+        reset_autopilot(terminal.autopilot);
+    }
+    if (terminal.replay) {
+        rewind_replay(terminal.replay, &game);
+        seek_replay(terminal.replay, &game, seek > 0 ? (uint32_t)seek : 0);
+        game.full_redraw = 1;
+    }
+    if (record_path) {
+        if (!begin_recording(&recorder, &game)) {
+            restore_terminal(&terminal);
+            printf("Not enough memory for the recording.\n");
+            return 1;
+        }
+        terminal.recorder = &recorder;
+    }
+    if (stream_path) {
+        stream_file = fopen(stream_path, "wb");
+        if (!stream_file || !open_stream(&stream, stream_file, &terminal.view, 0)) {
+            restore_terminal(&terminal);
+            printf("Could not write the frame stream '%s'.\n", stream_path);
+            return 1;
+        }
+        terminal.stream = &stream;
+        terminal.streamed_at = now_ns();
+    }
+    
+    game_loop(&terminal, &game);
+    restore_terminal(&terminal);
+    
+    if (game.status == GAME_WON) {
+        printf("You Win! The board is full. Final Score: %d\n", game.score);
+    }
+    else {
+        printf("Game Over! Final Score: %d\n", game.score);
+    }
+    
+    if (terminal.recorder) {
+        if (!save_replay(terminal.recorder, record_path)) {
+            printf("Could not write replay '%s'.\n", record_path);
+        }
+        free_recording(terminal.recorder);
+    }
+    if (terminal.stream) {
+        printf("Streamed %ld frames, %.1f bytes per frame.\n", stream.frames,
+               stream.frames > 0 ? (double)stream.bytes / stream.frames : 0.0);
+        close_stream(terminal.stream);
+    }
+    if (stream_file) {
+        fclose(stream_file);
+    }
+    if (terminal.replay) {
+        free_replay(terminal.replay);
+    }
+    if (terminal.autopilot) {
+        free_autopilot(terminal.autopilot);
+    }
+    free_view(&terminal.view);
+    free(terminal.out);
+    free_game(&game);
+    free_board(&board);
+    return 0;
+}
+
+void on_signal(int sig) {
+    (void)sig;
+    interrupted = 1;
+}
+
+int setup_terminal(Terminal *t, const Board *b) {
+    t->input = STDIN_FILENO;
+    t->output = STDOUT_FILENO;
+    
+    struct winsize size;
+    int max_width = b->width + 2;
+    int max_height = b->height + 4;
+    if (ioctl(t->output, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0) {
+        max_width = size.ws_col;
+        max_height = size.ws_row;
+    }
+    
+    ViewSink sink = {t, term_frame, term_text};
+    if (!create_view(&t->view, b, max_width, max_height, sink)) {
+        return 0;
+    }
+    
+    View *v = &t->view;
+    t->out_capacity = sizeof(SYNC_BEGIN) + sizeof(SYNC_END) + sizeof(CLEAR_LINE) + 2 * CURSOR_MAX +
+                      (size_t)(v->screen_width + 1) * (v->view_height + 2) + STATUS_MAX + OVERLAY_MAX +
+                      (size_t)MAX_DIRTY * (CURSOR_MAX + 1) + (size_t)v->status_width;
+    t->out = malloc(t->out_capacity);
+    if (!t->out) {
+        return 0;
+    }
+    
+    if (tcgetattr(t->input, &t->saved) == 0) {
+        struct termios raw = t->saved;
+        raw.c_lflag &= ~(tcflag_t)(ICANON | ECHO);
+        raw.c_iflag &= ~(tcflag_t)(IXON | ICRNL);
+        raw.c_cc[VMIN] = 1;
+        raw.c_cc[VTIME] = 0;
+        t->raw = tcsetattr(t->input, TCSAFLUSH, &raw) == 0;
+    }
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    sigaction(SIGHUP, &action, NULL);
+    
+    append(t, ENTER_SCREEN, sizeof(ENTER_SCREEN) - 1);
+    flush_output(t);
+    return 1;
+}
+
+void restore_terminal(Terminal *t) {
+    if (t->out) {
+        t->out_length = 0;
+        append(t, LEAVE_SCREEN, sizeof(LEAVE_SCREEN) - 1);
+        flush_output(t);
+    }
+    if (t->raw) {
+        tcsetattr(t->input, TCSAFLUSH, &t->saved);
+        t->raw = 0;
+    }
+}
+
+void append(Terminal *t, const char *text, size_t length) {
+    if (length > t->out_capacity - t->out_length) {
+        length = t->out_capacity - t->out_length;
+    }
+    
+    memcpy(&t->out[t->out_length], text, length);
+    t->out_length += length;
+}
+
+void append_cursor(Terminal *t, int x, int y) {
+    char cursor[CURSOR_MAX];
+    int length = snprintf(cursor, sizeof(cursor), "\x1b[%d;%dH", y + 1, x + 1);
+    
+    append(t, cursor, (size_t)length);
+}
+
+void term_frame(void *context, const char *text, int length) {
+    Terminal *t = context;
+    
+    append_cursor(t, 0, 0);
+    append(t, text, (size_t)length);
+    append(t, CLEAR_LINE, sizeof(CLEAR_LINE) - 1);
+    if (t->stream) {
+        stream_frame_text(t->stream, text, length);
+    }
+}
+
+void term_text(void *context, int x, int y, const char *text, int length) {
+    Terminal *t = context;
+    
+    append_cursor(t, x, y);
+    append(t, text, (size_t)length);
+    if (t->stream) {
+        stream_text(t->stream, x, y, text, length);
+    }
+}
+
+int flush_output(Terminal *t) {
+    size_t sent = 0;
+    
+    while (sent < t->out_length) {
+        ssize_t n = write(t->output, &t->out[sent], t->out_length - sent);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            t->out_length = 0;
+            return 0;
+        }
+        sent += (size_t)n;
+    }
+    
+    t->out_length = 0;
+    return 1;
+}
+
+void draw_game(Terminal *t, GameState *g) {
+    t->out_length = 0;
+    append(t, SYNC_BEGIN, sizeof(SYNC_BEGIN) - 1);
+    
+    size_t start = t->out_length;
+    draw_view(&t->view, g, t->full_frames);
+    if (t->stream) {
+        stream_frame(t);
+    }
+    if (t->out_length == start) {
+        t->out_length = 0;
+        return;
+    }
+    
+    append(t, SYNC_END, sizeof(SYNC_END) - 1);
+    flush_output(t);
+}
+
+void stream_frame(Terminal *t) {
+    uint32_t elapsed = (uint32_t)((now_ns() - t->streamed_at) / 1000000);
+    
+    t->streamed_at += (int64_t)elapsed * 1000000;
+    if (!emit_frame(t->stream, elapsed)) {
+        close_stream(t->stream);
+        t->stream = NULL;
+    }
+}
+
+void handle_key(Terminal *t, GameState *g, int command) {
+    switch (command) {
+        case INPUT_QUIT:
+            interrupted = 1;
+            break;
+        case INPUT_PAUSE:
+            g->paused = !g->paused;
+            t->changed = 1;
+            break;
+        default:
+            if (!t->autopilot && !t->replay) {
+                queue_turn(g, (Direction)command);
+            }
+            break;
+    }
+}
+
+void read_input(Terminal *t, GameState *g) {
+    static const int arrows[4] = {INPUT_UP, INPUT_DOWN, INPUT_RIGHT, INPUT_LEFT};
+    unsigned char keys[ESCAPE_LENGTH + INPUT_BATCH];
+    int held = t->escape_length;
+    
+    memcpy(keys, t->escape, (size_t)held);
+    ssize_t got = read(t->input, keys + held, INPUT_BATCH);
+    if (got == 0) {
+        interrupted = 1;
+    }
+    if (got <= 0) return;
+    
+    ssize_t count = held + got;
+    t->escape_length = 0;
+    for (ssize_t i = 0; i < count; i++) {
+        if (keys[i] == ' ') {
+            handle_key(t, g, INPUT_PAUSE);
+        }
+        else if (keys[i] == 'q') {
+            handle_key(t, g, INPUT_QUIT);
+        }
+        else if (keys[i] != 0x1b) {
+            continue;
+        }
+        else if (i + 2 < count && (keys[i + 1] == '[' || keys[i + 1] == 'O') && keys[i + 2] >= 'A' && keys[i + 2] <= 'D') {
+            handle_key(t, g, arrows[keys[i + 2] - 'A']);
+            i += 2;
+        }
+        else if (i + 1 == count || (i + 2 == count && (keys[i + 1] == '[' || keys[i + 1] == 'O'))) {
+            t->escape_length = (int)(count - i);
+            memcpy(t->escape, &keys[i], (size_t)t->escape_length);
+            t->escape_deadline = now_ns() + (int64_t)ESCAPE_TIMEOUT_MS * 1000000;
+            break;
+        }
+    }
+}
+
+void expire_escape(Terminal *t, GameState *g) {
+    if (t->escape_length == 0 || now_ns() < t->escape_deadline) return;
+    
+    if (t->escape_length == 1) {
+        handle_key(t, g, INPUT_QUIT);
+    }
+    t->escape_length = 0;
+}
+
+int64_t now_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+int64_t tick_period(GameState *g) {
+    return (int64_t)tick_period_ms(g) * 1000000;
+}
+
+void wait_input(Terminal *t, GameState *g, int64_t deadline) {
+    struct pollfd fd = {t->input, POLLIN, 0};
+    int timeout = -1;
+    
+    if (t->escape_length > 0 && (deadline < 0 || t->escape_deadline < deadline)) {
+        deadline = t->escape_deadline;
+    }
+    
+    if (deadline >= 0) {
+        int64_t remaining = deadline - now_ns();
+        if (remaining <= 0) {
+            expire_escape(t, g);
+            return;
+        }
+        timeout = (int)((remaining + 999999) / 1000000);
+    }
+    
+    if (poll(&fd, 1, timeout) > 0 && (fd.revents & (POLLIN | POLLHUP))) {
+        read_input(t, g);
+    }
+    expire_escape(t, g);
+}
+
+int replay_done(Terminal *t) {
+    return t->replay && t->replay->tick >= t->replay->header.ticks;
+}
+
+void advance_game(Terminal *t, GameState *g) {
+    if (t->replay) {
+        replay_step(t->replay, g);
+        return;
+    }
+    
+    step(g, t->autopilot ? autopilot_action(t->autopilot, g) : ACTION_NONE);
+    if (t->recorder && !record_tick(t->recorder, g)) {
+        free_recording(t->recorder);
+        t->recorder = NULL;
+    }
+}
+
+void game_loop(Terminal *t, GameState *g) {
+    int64_t next_tick = now_ns();
+    
+    t->changed = 1;
+    while (!interrupted && g->status == GAME_RUNNING && !replay_done(t)) {
+        int64_t now = now_ns();
+        int ticked = 0;
+        
+        if (g->paused) {
+            next_tick = now;
+        }
+        else {
+            if (now - next_tick > MAX_CATCH_UP_TICKS * tick_period(g)) {
+                next_tick = now;
+            }
+            
+            while (!interrupted && g->status == GAME_RUNNING && !replay_done(t) && now >= next_tick) {
+                advance_game(t, g);
+                next_tick += tick_period(g);
+                ticked = 1;
+            }
+        }
+        
+        if (ticked || t->changed) {
+            draw_game(t, g);
+            t->changed = 0;
+        }
+        
+        wait_input(t, g, g->paused ? -1 : next_tick);
+    }
+}
@@ -0,0 +1,80 @@
+#include "snake_timing.h"
+
+void record_sample(Histogram *h, uint64_t ns) {
+    h->buckets[bucket_index(ns)]++;
+    h->count++;
+    if (ns > h->max) h->max = ns;
+}
+
+int bucket_index(uint64_t ns) {
+    if (ns < SUB_BUCKETS) return (int)ns;
+    
+    int msb = 63;
+    while (!(ns >> msb)) {
+        msb--;
+    }
+    
+    int shift = msb - SUB_BUCKET_BITS;
+    int index = SUB_BUCKETS * (shift + 1) + (int)((ns >> shift) & (SUB_BUCKETS - 1));
+    return index < TIMING_BUCKETS ? index : TIMING_BUCKETS - 1;
+}
+
+uint64_t bucket_low(int index) {
+    if (index < SUB_BUCKETS) return (uint64_t)index;
+    
+    int shift = index / SUB_BUCKETS - 1;
+    return (uint64_t)(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+}
+
+uint64_t bucket_high(int index) {
+    if (index < SUB_BUCKETS) return (uint64_t)index;
+    
+    int shift = index / SUB_BUCKETS - 1;
+    return bucket_low(index) + ((uint64_t)1 << shift) - 1;
+}
+
+uint64_t histogram_percentile(const Histogram *h, double fraction) {
+    if (h->count == 0) return 0;
+    
+    uint64_t rank = (uint64_t)(fraction * (double)(h->count - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < TIMING_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint64_t high = bucket_high(i);
+            return high < h->max ? high : h->max;
+        }
+    }
+    
+    return h->max;
+}
+
+void write_histogram(FILE *f, const Histogram *h) {
+    fprintf(f, "# %s: %llu samples, p50 %llu ns, p90 %llu ns, p99 %llu ns, max %llu ns\n", h->name,
+            (unsigned long long)h->count,
+            (unsigned long long)histogram_percentile(h, 0.50),
+            (unsigned long long)histogram_percentile(h, 0.90),
+            (unsigned long long)histogram_percentile(h, 0.99),
+            (unsigned long long)h->max);
+    
+    for (int i = 0; i < TIMING_BUCKETS; i++) {
+        if (h->buckets[i] == 0) continue;
+        
+        fprintf(f, "%s %llu %llu %llu\n", h->name,
+                (unsigned long long)bucket_low(i),
+                (unsigned long long)bucket_high(i),
+                (unsigned long long)h->buckets[i]);
+    }
+}
+
+int dump_histograms(const char *path, const Histogram *histograms, int count) {
+    FILE *f = fopen(path, "w");
+    if (!f) return 0;
+    
+    fprintf(f, "# phase low_ns high_ns count\n");
+    for (int i = 0; i < count; i++) {
+        write_histogram(f, &histograms[i]);
+    }
+    
+    return fclose(f) == 0;
+}
\ No newline at end of file
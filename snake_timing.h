@@ -0,0 +1,26 @@
+#ifndef SNAKE_TIMING_H
+#define SNAKE_TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define SUB_BUCKET_BITS 4
+#define SUB_BUCKETS (1 << SUB_BUCKET_BITS)
+#define TIMING_BUCKETS (SUB_BUCKETS * 60)
+
+typedef struct {
+    const char *name;
+    uint64_t count;
+    uint64_t max;
+    uint64_t buckets[TIMING_BUCKETS];
+} Histogram;
+
+void record_sample(Histogram *h, uint64_t ns);
+int bucket_index(uint64_t ns);
+uint64_t bucket_low(int index);
+uint64_t bucket_high(int index);
+uint64_t histogram_percentile(const Histogram *h, double fraction);
+void write_histogram(FILE *f, const Histogram *h);
+int dump_histograms(const char *path, const Histogram *histograms, int count);
+
+#endif
@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_view.h"
+
+int create_view(View *v, const Board *b, int max_width, int max_height, ViewSink sink) {
+    memset(v, 0, sizeof(*v));
+    v->sink = sink;
+    v->view_width = b->width < max_width - 2 ? b->width : max_width - 2;
+    v->view_height = b->height < max_height - 4 ? b->height : max_height - 4;
+    if (v->view_width < 1) v->view_width = 1;
+    if (v->view_height < 1) v->view_height = 1;
+    v->screen_width = v->view_width + 2;
+    v->screen_height = v->view_height + 4;
+    v->status_width = 2 * v->screen_width;
+    
+    size_t frame_size = (size_t)(v->screen_width + 1) * (v->view_height + 2) + STATUS_MAX + OVERLAY_MAX;
+    v->screen_buffer = malloc(frame_size);
+    v->presented = malloc(frame_size);
+    v->status_line = malloc((size_t)v->status_width + STATUS_MAX + OVERLAY_MAX);
+    if (!v->screen_buffer || !v->presented || !v->status_line) {
+        free_view(v);
+        return 0;
+    }
+    
+    return 1;
+}
+
+void free_view(View *v) {
+    free(v->screen_buffer);
+    free(v->presented);
+    free(v->status_line);
+    memset(v, 0, sizeof(*v));
+}
+
+int scroll_axis(int origin, int head, int view, int size) {
+    if (view >= size) return 0;
+    
+    int offset = (head - origin + size) % size;
+    if (offset >= view / 4 && offset < view - view / 4) {
+        return origin;
+    }
+    
+    return (head - view / 2 + size) % size;
+}
+
+int follow_head(View *v, GameState *g) {
+    const Board *b = g->board;
+    Cell head = segment(g, 0);
+    int view_x = scroll_axis(v->view_x, cell_x(b, head), v->view_width, b->width);
+    int view_y = scroll_axis(v->view_y, cell_y(b, head), v->view_height, b->height);
+    int moved = view_x != v->view_x || view_y != v->view_y;
+    
+    v->view_x = view_x;
+    v->view_y = view_y;
+    return moved;
+}
+
+Cell view_cell(View *v, const Board *b, int x, int y) {
+    return cell_at(b, (v->view_x + x) % b->width, (v->view_y + y) % b->height);
+}
+
+int view_position(View *v, const Board *b, Cell cell, int *x, int *y) {
+    int vx = (cell_x(b, cell) - v->view_x + b->width) % b->width;
+    int vy = (cell_y(b, cell) - v->view_y + b->height) % b->height;
+    
+    *x = vx + 1;
+    *y = vy + 1;
+    return vx < v->view_width && vy < v->view_height;
+}
+
+char cell_char(GameState *g, Cell cell) {
+    if (cell_occupied(g, cell)) {
+        return cell == segment(g, 0) ? 'O' : 'o';
+    }
+    
+    if (cell == g->food) {
+        return '*';
+    }
+    
+    return ' ';
+}
+
+int status_changed(View *v, GameState *g) {
+    return v->status_dirty || g->score != v->drawn_score || g->snake_length != v->drawn_length || g->paused != v->drawn_paused;
+}
+
+int format_status(View *v, GameState *g, char *buffer) {
+    return sprintf(buffer, "Score: %d | Length: %d | ESC=Quit SPACE=Pause%s%s",
+                   g->score, g->snake_length, g->paused ? " [PAUSED]" : "", v->overlay);
+}
+
+int frame_changed(View *v, const char *text, int length) {
+    if (length == v->presented_length && memcmp(text, v->presented, (size_t)length) == 0) {
+        return 0;
+    }
+    
+    memcpy(v->presented, text, (size_t)length);
+    v->presented_length = length;
+    return 1;
+}
+
+void draw_view(View *v, GameState *g, int full) {
+    if (follow_head(v, g)) {
+        g->full_redraw = 1;
+    }
+    
+    if (full || g->full_redraw) {
+        draw_full(v, g);
+    }
+    else {
+        draw_diff(v, g);
+    }
+    
+    end_frame(v, g);
+}
+
+void draw_full(View *v, GameState *g) {
+    char *screen_buffer = v->screen_buffer;
+    int buf_idx = 0;
+    
+    for (int x = 0; x < v->screen_width; x++) {
+        screen_buffer[buf_idx++] = '#';
+    }
+    screen_buffer[buf_idx++] = '\n';
+    
+    for (int y = 0; y < v->view_height; y++) {
+        screen_buffer[buf_idx++] = '#';
+        
+        for (int x = 0; x < v->view_width; x++) {
+            screen_buffer[buf_idx++] = cell_char(g, view_cell(v, g->board, x, y));
+        }
+        
+        screen_buffer[buf_idx++] = '#';
+        screen_buffer[buf_idx++] = '\n';
+    }
+    
+    for (int x = 0; x < v->screen_width; x++) {
+        screen_buffer[buf_idx++] = '#';
+    }
+    screen_buffer[buf_idx++] = '\n';
+    
+    buf_idx += format_status(v, g, &screen_buffer[buf_idx]);
+    if (frame_changed(v, screen_buffer, buf_idx)) {
+        v->sink.write_frame(v->sink.context, screen_buffer, buf_idx);
+    }
+}
+
+void draw_diff(View *v, GameState *g) {
+    for (int i = 0; i < g->dirty_count; i++) {
+        Cell cell = g->dirty_cells[i];
+        char ch = cell_char(g, cell);
+        int x;
+        int y;
+        if (view_position(v, g->board, cell, &x, &y)) {
+            v->sink.write_text(v->sink.context, x, y, &ch, 1);
+            v->presented_length = 0;
+        }
+    }
+    
+    if (status_changed(v, g)) {
+        char *status = v->status_line;
+        int status_len = format_status(v, g, status);
+        if (status_len < v->status_width) {
+            memset(&status[status_len], ' ', v->status_width - status_len);
+        }
+        
+        v->sink.write_text(v->sink.context, 0, v->view_height + 2, status, v->status_width);
+        v->presented_length = 0;
+    }
+}
+
+void end_frame(View *v, GameState *g) {
+    g->dirty_count = 0;
+    g->full_redraw = 0;
+    v->status_dirty = 0;
+    v->drawn_score = g->score;
+    v->drawn_length = g->snake_length;
+    v->drawn_paused = g->paused;
+}
\ No newline at end of file
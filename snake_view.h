@@ -0,0 +1,50 @@
+#ifndef SNAKE_VIEW_H
+#define SNAKE_VIEW_H
+
+#include "snake_core.h"
+
+#define STATUS_MAX 96
+#define OVERLAY_MAX 96
+
+typedef struct {
+    void *context;
+    void (*write_frame)(void *context, const char *text, int length);
+    void (*write_text)(void *context, int x, int y, const char *text, int length);
+} ViewSink;
+
+typedef struct {
+    ViewSink sink;
+    int view_width;
+    int view_height;
+    int view_x;
+    int view_y;
+    int screen_width;
+    int screen_height;
+    int status_width;
+    int drawn_score;
+    int drawn_length;
+    int drawn_paused;
+    int status_dirty;
+    char *screen_buffer;
+    char *status_line;
+    char *presented;
+    int presented_length;
+    char overlay[OVERLAY_MAX];
+} View;
+
+int create_view(View *v, const Board *b, int max_width, int max_height, ViewSink sink);
+void free_view(View *v);
+int scroll_axis(int origin, int head, int view, int size);
+int follow_head(View *v, GameState *g);
+Cell view_cell(View *v, const Board *b, int x, int y);
+int view_position(View *v, const Board *b, Cell cell, int *x, int *y);
+char cell_char(GameState *g, Cell cell);
+int status_changed(View *v, GameState *g);
+int format_status(View *v, GameState *g, char *buffer);
+int frame_changed(View *v, const char *text, int length);
+void draw_view(View *v, GameState *g, int full);
+void draw_full(View *v, GameState *g);
+void draw_diff(View *v, GameState *g);
+void end_frame(View *v, GameState *g);
+
+#endif
@@ -0,0 +1,107 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "snake_stream.h"
+
+#define HOME_CURSOR "\x1b[H"
+#define CLEAR_SCREEN "\x1b[2J"
+#define CLEAR_LINE "\x1b[K"
+
+void wait_ms(uint32_t ms);
+void show_screen(const StreamReader *r, char *out);
+
+int main(int argc, char *argv[]) {
+    const char *path = "-";
+    int fast = 0;
+    int stats = 0;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fast") == 0) {
+            fast = 1;
+        }
+        else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 1;
+        }
+        else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            path = argv[i];
+        }
+        else {
+            fprintf(stderr, "usage: %s [--fast] [--stats] [FILE|-]\n", argv[0]);
+            return 1;
+        }
+    }
+    
+    FILE *file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    StreamReader reader;
+    if (!file || !open_stream_reader(&reader, file)) {
+        fprintf(stderr, "could not read a frame stream from %s\n", path);
+        return 1;
+    }
+    
+    char *out = malloc((size_t)(reader.columns + sizeof(CLEAR_LINE) + 1) * reader.rows + sizeof(HOME_CURSOR));
+    if (!out) return 1;
+    
+    if (!stats) {
+        fputs(CLEAR_SCREEN, stdout);
+    }
+    
+    uint32_t elapsed;
+    int key;
+    long long played_ms = 0;
+    while (read_stream_frame(&reader, &elapsed, &key)) {
+        played_ms += elapsed;
+        if (stats) continue;
+        
+        if (!fast) {
+            wait_ms(elapsed);
+        }
+        show_screen(&reader, out);
+    }
+    
+    if (!feof(file)) {
+        fprintf(stderr, "stream ended with a corrupt frame\n");
+    }
+    printf("frames:      %ld (%ld key)\n", reader.frames, reader.keys);
+    printf("bytes:       %lld\n", reader.bytes);
+    printf("bytes/frame: %.1f\n", reader.frames > 0 ? (double)reader.bytes / reader.frames : 0.0);
+    printf("screen:      %d x %d (%d bytes)\n", reader.columns, reader.rows, reader.columns * reader.rows);
+    printf("seconds:     %.1f\n", (double)played_ms / 1000);
+    
+    free(out);
+    close_stream_reader(&reader);
+    if (file != stdin) {
+        fclose(file);
+    }
+    return 0;
+}
+
+void wait_ms(uint32_t ms) {
+    struct timespec pause = {(time_t)(ms / 1000), (long)(ms % 1000) * 1000000L};
+    nanosleep(&pause, NULL);
+}
+
+void show_screen(const StreamReader *r, char *out) {
+    size_t length = sizeof(HOME_CURSOR) - 1;
+    
+    memcpy(out, HOME_CURSOR, length);
+    for (int y = 0; y < r->rows; y++) {
+        const char *row = &r->screen[y * r->columns];
+        int width = r->columns;
+        while (width > 0 && row[width - 1] == ' ') {
+            width--;
+        }
+        
+        memcpy(&out[length], row, (size_t)width);
+        length += (size_t)width;
+        memcpy(&out[length], CLEAR_LINE, sizeof(CLEAR_LINE) - 1);
+        length += sizeof(CLEAR_LINE) - 1;
+        out[length++] = '\n';
+    }
+    
+    fwrite(out, 1, length, stdout);
+    fflush(stdout);
+}
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "snake_wheel.h"
+
+void unlink_timer(TimerWheel *w, int id);
+
+int create_wheel(TimerWheel *w, int capacity, int64_t resolution, int64_t now) {
+    memset(w, 0, sizeof(*w));
+    w->timers = malloc(sizeof(WheelTimer) * (size_t)capacity);
+    if (!w->timers) return 0;
+    
+    w->resolution = resolution;
+    w->current = now / resolution;
+    w->capacity = capacity;
+    for (int i = 0; i < WHEEL_SLOTS; i++) {
+        w->heads[i] = WHEEL_NONE;
+    }
+    for (int i = 0; i < capacity; i++) {
+        w->timers[i].slot = WHEEL_NONE;
+    }
+    return 1;
+}
+
+void free_wheel(TimerWheel *w) {
+    free(w->timers);
+    memset(w, 0, sizeof(*w));
+}
+
+void unlink_timer(TimerWheel *w, int id) {
+    WheelTimer *t = &w->timers[id];
+    
+    if (t->prev != WHEEL_NONE) {
+        w->timers[t->prev].next = t->next;
+    }
+    else {
+        w->heads[t->slot] = t->next;
+    }
+    
+    if (t->next != WHEEL_NONE) {
+        w->timers[t->next].prev = t->prev;
+    }
+    t->slot = WHEEL_NONE;
+    w->count--;
+}
+
+void schedule_timer(TimerWheel *w, int id, int64_t due) {
+    WheelTimer *t = &w->timers[id];
+    int64_t tick = due / w->resolution;
+    
+    if (t->slot != WHEEL_NONE) {
+        unlink_timer(w, id);
+    }
+    if (tick <= w->current) {
+        tick = w->current + 1;
+    }
+    
+    t->due = due;
+    t->slot = (int)(tick & (WHEEL_SLOTS - 1));
+    t->prev = WHEEL_NONE;
+    t->next = w->heads[t->slot];
+    if (t->next != WHEEL_NONE) {
+        w->timers[t->next].prev = id;
+    }
+    w->heads[t->slot] = id;
+    w->count++;
+}
+
+void cancel_timer(TimerWheel *w, int id) {
+    if (w->timers[id].slot != WHEEL_NONE) {
+        unlink_timer(w, id);
+    }
+}
+
+int64_t next_expiry(const TimerWheel *w) {
+    if (w->count == 0) return -1;
+    
+    for (int64_t tick = w->current + 1; tick <= w->current + WHEEL_SLOTS; tick++) {
+        if (w->heads[tick & (WHEEL_SLOTS - 1)] != WHEEL_NONE) {
+            return tick * w->resolution;
+        }
+    }
+    
+    return (w->current + WHEEL_SLOTS) * w->resolution;
+}
+
+int advance_wheel(TimerWheel *w, int64_t now, WheelExpire expire, void *context) {
+    int64_t target = now / w->resolution;
+    int64_t first = w->current + 1;
+    int fired = 0;
+    
+    if (target - first >= WHEEL_SLOTS) {
+        first = target - WHEEL_SLOTS + 1;
+    }
+    
+    for (int64_t tick = first; tick <= target; tick++) {
+        int id = w->heads[tick & (WHEEL_SLOTS - 1)];
+        w->current = tick;
+        while (id != WHEEL_NONE) {
+            WheelTimer *t = &w->timers[id];
+            int next = t->next;
+            if (t->due / w->resolution <= target) {
+                int64_t due = t->due;
+                unlink_timer(w, id);
+                expire(context, id, due);
+                fired++;
+            }
+            id = next;
+        }
+    }
+    
+    if (target > w->current) {
+        w->current = target;
+    }
+    return fired;
+}
@@ -0,0 +1,34 @@
+#ifndef SNAKE_WHEEL_H
+#define SNAKE_WHEEL_H
+
+#include <stdint.h>
+
+#define WHEEL_SLOTS 1024
+#define WHEEL_NONE -1
+
+typedef struct {
+    int64_t due;
+    int next;
+    int prev;
+    int slot;
+} WheelTimer;
+
+typedef struct {
+    int64_t resolution;
+    int64_t current;
+    int count;
+    int capacity;
+    int heads[WHEEL_SLOTS];
+    WheelTimer *timers;
+} TimerWheel;
+
+typedef void (*WheelExpire)(void *context, int id, int64_t due);
+
+int create_wheel(TimerWheel *w, int capacity, int64_t resolution, int64_t now);
+void free_wheel(TimerWheel *w);
+void schedule_timer(TimerWheel *w, int id, int64_t due);
+void cancel_timer(TimerWheel *w, int id);
+int64_t next_expiry(const TimerWheel *w);
+int advance_wheel(TimerWheel *w, int64_t now, WheelExpire expire, void *context);
+
+#endif
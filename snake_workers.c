@@ -0,0 +1,246 @@
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+#include "snake_core.h"
+#include "snake_workers.h"
+
+#define TASK_EMPTY -1
+#define TASK_ABORT -2
+
+typedef struct {
+    CACHE_ALIGN atomic_long top;
+    CACHE_ALIGN atomic_long bottom;
+    long *tasks;
+} TaskDeque;
+
+typedef struct WorkPool WorkPool;
+
+typedef struct {
+    WorkPool *pool;
+    int index;
+    uint64_t rng;
+    WorkerStats stats;
+} Worker;
+
+struct WorkPool {
+    int threads;
+    TaskDeque *deques;
+    Worker *workers;
+    WorkFn fn;
+    void *context;
+    CACHE_ALIGN atomic_long remaining;
+};
+
+long deque_pop(TaskDeque *d);
+long deque_steal(TaskDeque *d);
+long steal_task(Worker *w);
+void work_loop(Worker *w);
+
+#if defined(_WIN32)
+DWORD WINAPI worker_main(LPVOID arg);
+#else
+void *worker_main(void *arg);
+#endif
+
+long deque_pop(TaskDeque *d) {
+    long b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&d->top, memory_order_relaxed);
+    
+    if (t > b) {
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return TASK_EMPTY;
+    }
+    
+    long task = d->tasks[b];
+    if (t == b) {
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            task = TASK_EMPTY;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    
+    return task;
+}
+
+long deque_steal(TaskDeque *d) {
+    long t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    
+    if (t >= b) {
+        return TASK_EMPTY;
+    }
+    
+    long task = d->tasks[t];
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return TASK_ABORT;
+    }
+    
+    return task;
+}
+
+long steal_task(Worker *w) {
+    WorkPool *pool = w->pool;
+    
+    for (int attempt = 0; attempt < 2 * pool->threads; attempt++) {
+        w->rng ^= w->rng << 13;
+        w->rng ^= w->rng >> 7;
+        w->rng ^= w->rng << 17;
+        
+        int victim = (int)(w->rng % (uint64_t)pool->threads);
+        if (victim == w->index) continue;
+        
+        long task = deque_steal(&pool->deques[victim]);
+        if (task >= 0) {
+            w->stats.steals++;
+            return task;
+        }
+    }
+    
+    return TASK_EMPTY;
+}
+
+void work_loop(Worker *w) {
+    WorkPool *pool = w->pool;
+    TaskDeque *own = &pool->deques[w->index];
+    
+    while (atomic_load_explicit(&pool->remaining, memory_order_acquire) > 0) {
+        long task = deque_pop(own);
+        if (task < 0) {
+            task = steal_task(w);
+        }
+        
+        if (task < 0) {
+#if defined(_WIN32)
+            SwitchToThread();
+#else
+            sched_yield();
+#endif
+            continue;
+        }
+        
+        pool->fn(pool->context, task, w->index);
+        w->stats.tasks_run++;
+        atomic_fetch_sub_explicit(&pool->remaining, 1, memory_order_release);
+    }
+}
+
+#if defined(_WIN32)
+DWORD WINAPI worker_main(LPVOID arg) {
+    work_loop((Worker *)arg);
+    return 0;
+}
+#else
+void *worker_main(void *arg) {
+    work_loop((Worker *)arg);
+    return NULL;
+}
+#endif
+
+int run_work_stealing(int threads, long tasks, WorkFn fn, void *context, WorkerStats *stats) {
+    WorkPool pool;
+    
+    if (threads < 1) threads = 1;
+    pool.threads = threads;
+    pool.fn = fn;
+    pool.context = context;
+    atomic_init(&pool.remaining, tasks);
+    pool.deques = alloc_aligned(sizeof(TaskDeque) * (size_t)threads);
+    pool.workers = calloc(threads, sizeof(Worker));
+    if (pool.deques) {
+        memset(pool.deques, 0, sizeof(TaskDeque) * (size_t)threads);
+    }
+    
+    long per_deque = tasks / threads + 1;
+    int ok = pool.deques && pool.workers;
+    for (int i = 0; ok && i < threads; i++) {
+        pool.deques[i].tasks = malloc(sizeof(long) * per_deque);
+        ok = pool.deques[i].tasks != NULL;
+    }
+    
+    if (ok) {
+        for (int i = 0; i < threads; i++) {
+            atomic_init(&pool.deques[i].top, 0);
+            atomic_init(&pool.deques[i].bottom, 0);
+            pool.workers[i].pool = &pool;
+            pool.workers[i].index = i;
+            pool.workers[i].rng = 0x9E3779B97F4A7C15ULL * (uint64_t)(i + 1);
+        }
+        
+        for (long task = 0; task < tasks; task++) {
+            TaskDeque *d = &pool.deques[task % threads];
+            long b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+            d->tasks[b] = task;
+            atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        }
+
+#if defined(_WIN32)
+        HANDLE *handles = calloc(threads, sizeof(HANDLE));
+        ok = handles != NULL;
+        for (int i = 1; ok && i < threads; i++) {
+            handles[i] = CreateThread(NULL, 0, worker_main, &pool.workers[i], 0, NULL);
+        }
+        if (ok) {
+            work_loop(&pool.workers[0]);
+        }
+        for (int i = 1; ok && i < threads; i++) {
+            if (handles[i]) {
+                WaitForSingleObject(handles[i], INFINITE);
+                CloseHandle(handles[i]);
+            }
+        }
+        free(handles);
+#else
+        pthread_t *handles = calloc(threads, sizeof(pthread_t));
+        int *started = calloc(threads, sizeof(int));
+        ok = handles && started;
+        for (int i = 1; ok && i < threads; i++) {
+            started[i] = pthread_create(&handles[i], NULL, worker_main, &pool.workers[i]) == 0;
+        }
+        if (ok) {
+            work_loop(&pool.workers[0]);
+        }
+        for (int i = 1; ok && i < threads; i++) {
+            if (started[i]) {
+                pthread_join(handles[i], NULL);
+            }
+        }
+        free(handles);
+        free(started);
+#endif
+        
+        for (int i = 0; ok && stats && i < threads; i++) {
+            stats[i] = pool.workers[i].stats;
+        }
+    }
+    
+    for (int i = 0; pool.deques && i < threads; i++) {
+        free(pool.deques[i].tasks);
+    }
+    free_aligned(pool.deques);
+    free(pool.workers);
+    return ok;
+}
+
+int hardware_threads() {
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
@@ -0,0 +1,14 @@
+#ifndef SNAKE_WORKERS_H
+#define SNAKE_WORKERS_H
+
+typedef void (*WorkFn)(void *context, long task, int worker);
+
+typedef struct {
+    long tasks_run;
+    long steals;
+} WorkerStats;
+
+int run_work_stealing(int threads, long tasks, WorkFn fn, void *context, WorkerStats *stats);
+int hardware_threads();
+
+#endif
@@ -1,317 +1,757 @@
 #include <windows.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <conio.h>
 
-#define WIDTH 30
-#define HEIGHT 15
-#define MAX_LENGTH 500
+#include "snake_core.h"
+#include "snake_autopilot.h"
+#include "snake_pipeline.h"
+#include "snake_replay.h"
+#include "snake_timing.h"
+#include "snake_view.h"
 
-typedef struct {
-    int x;
-    int y;
-} Position;
+#pragma comment(lib, "winmm.lib")
+
+#define TEXT_ATTR (FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE)
+#define MAX_CATCH_UP_TICKS 4
+#define INPUT_BATCH 16
+#define OVERLAY_PERIOD_MS 500
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
 
 typedef enum {
-    UP,
-    DOWN,
-    LEFT,
-    RIGHT
-} Direction;
-
-Position snake[MAX_LENGTH];
-int snake_length = 3;
-Position food;
-Direction current_dir = RIGHT;
-Direction next_dir = RIGHT;
-int dir_changed = 0;
-int score = 0;
-int game_running = 1;
-int paused = 0;
-int speed = 100;
-
-HANDLE console;
-CONSOLE_CURSOR_INFO cursor_info;
-char screen_buffer[(WIDTH + 3) * (HEIGHT + 4)];
-
-void init_game();
-void setup_console();
-void hide_cursor();
-void draw_game();
-void spawn_food();
-int check_collision();
-void move_snake();
-void process_input();
-void game_loop();
-void cleanup();
-
-int main() {
-    srand(time(NULL));
-    setup_console();
-    init_game();
-    game_loop();
-    cleanup();
+    RENDER_FULL,
+    RENDER_DIFF,
+    RENDER_BLIT
+} RenderMode;
+
+typedef enum {
+    PHASE_INPUT,
+    PHASE_MOVE,
+    PHASE_DRAW,
+    PHASE_FRAME,
+    PHASE_LATENCY,
+    PHASE_COUNT
+} Phase;
+
+typedef struct {
+    Histogram phases[PHASE_COUNT];
+    LONGLONG frequency;
+    LONGLONG key_time[TURN_QUEUE_SIZE];
+    LONGLONG turn_time;
+    LONGLONG next_overlay;
+} Instrument;
+
+typedef struct {
+    HANDLE output;
+    HANDLE input;
+    CONSOLE_CURSOR_INFO cursor_info;
+    RenderMode render_mode;
+    atomic_int quit;
+    View view;
+    CHAR_INFO *back_buffer;
+    GameState shown;
+    Autopilot *autopilot;
+    ReplayPlayer *replay;
+    ReplayWriter *recorder;
+    Instrument *timing;
+    HANDLE input_ready;
+    HANDLE frame_ready;
+    HANDLE stop;
+    InputQueue inputs;
+    FrameBuffer frames;
+} Console;
+
+typedef struct {
+    LARGE_INTEGER frequency;
+    HANDLE timer;
+    int period_set;
+    LONGLONG spin_margin;
+} Timer;
+
+int setup_console(Console *c, const Board *b);
+void hide_cursor(Console *c);
+void console_frame(void *context, const char *text, int length);
+void console_text(void *context, int x, int y, const char *text, int length);
+WORD char_attr(char ch);
+void put_cell(Console *c, int x, int y, char ch);
+void draw_blit(Console *c, GameState *g);
+void draw_game(Console *c, GameState *g);
+void read_keys(Console *c);
+void post_key(Console *c, WORD key);
+DWORD WINAPI input_main(LPVOID context);
+DWORD WINAPI render_main(LPVOID context);
+void render_frame(Console *c);
+int handle_input(Console *c, GameState *g, const InputEvent *e);
+void queue_key(Console *c, GameState *g, const InputEvent *e);
+int process_input(Console *c, GameState *g);
+void init_timer(Timer *t);
+LONGLONG qpc_now();
+LONGLONG tick_period(Timer *t, GameState *g);
+int wait_until(Timer *t, Console *c, GameState *g, LONGLONG deadline);
+int replay_done(Console *c);
+void advance_game(Console *c, GameState *g);
+void publish_state(Console *c, GameState *g, LONGLONG input_time);
+void game_loop(Timer *t, Console *c, GameState *g);
+int run_game(Timer *t, Console *c, GameState *g);
+void init_instrument(Instrument *ins, LONGLONG frequency);
+uint64_t qpc_ns(Instrument *ins, LONGLONG delta);
+void note_turn(Instrument *ins, GameState *g, int head, int count);
+LONGLONG time_ticks(Instrument *ins, LONGLONG start, LONGLONG done);
+void time_frame(Console *c, const Frame *f, LONGLONG start, LONGLONG done);
+void update_overlay(Console *c);
+void cleanup(Timer *t, Console *c, GameState *g);
+
+int main(int argc, char *argv[]) {
+    Board board;
+    GameState game;
+    Console console = {0};
+    Timer timer = {0};
+    Autopilot autopilot;
+    AutopilotMode mode = AUTOPILOT_PATH;
+    int use_autopilot = 0;
+    ReplayPlayer replay;
+    ReplayWriter recorder;
+    Instrument instrument;
+    const char *timing_path = NULL;
+    const char *record_path = NULL;
+    const char *replay_path = NULL;
+    long seek = 0;
+    
+    uint64_t seed = (uint64_t)time(NULL);
+    int width = DEFAULT_WIDTH;
+    int height = DEFAULT_HEIGHT;
+    
+    console.render_mode = RENDER_DIFF;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--full") == 0) {
+            console.render_mode = RENDER_FULL;
+        }
+        else if (strcmp(argv[i], "--blit") == 0) {
+            console.render_mode = RENDER_BLIT;
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc) {
+            height = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--autopilot") == 0 && i + 1 < argc) {
+            if (!parse_autopilot_mode(argv[++i], &mode)) {
+                printf("Unknown autopilot mode '%s'; use path or cycle.\n", argv[i]);
+                return 1;
+            }
+            use_autopilot = 1;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        }
+        else if (strcmp(argv[i], "--seek") == 0 && i + 1 < argc) {
+            seek = atol(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--timing") == 0 && i + 1 < argc) {
+            timing_path = argv[++i];
+        }
+    }
+    
+    if (replay_path) {
+        if (!load_replay(&replay, replay_path)) {
+            printf("Could not read replay '%s'.\n", replay_path);
+            return 1;
+        }
+        console.replay = &replay;
+        width = replay.header.width;
+        height = replay.header.height;
+        use_autopilot = 0;
+        record_path = NULL;
+    }
+    
+    if (!create_board(&board, width, height)) {
+        printf("The board must be between %d and %d cells on each side.\n", MIN_BOARD_SIDE, MAX_BOARD_SIDE);
+        return 1;
+    }
+    if (!create_game(&game, &board, NULL) || !setup_console(&console, &board)) {
+        printf("Not enough memory for a %d x %d board.\n", width, height);
+        return 1;
+    }
+    if (use_autopilot) {
+        if (!create_autopilot(&autopilot, &board, mode)) {
+            printf("Not enough memory for the autopilot.\n");
+            return 1;
+        }
+        console.autopilot = &autopilot;
+    }
+    
+    init_timer(&timer);
+    if (timing_path) {
+        init_instrument(&instrument, timer.frequency.QuadPart);
+        console.timing = &instrument;
+    }
+    init_game(&game, seed);
+    if (console.autopilot) {
+        reset_autopilot(console.autopilot);
+    }
+    if (console.replay) {
+        rewind_replay(console.replay, &game);
+        seek_replay(console.replay, &game, seek > 0 ? (uint32_t)seek : 0);
+        game.full_redraw = 1;
+    }
+    if (record_path) {
+        if (!begin_recording(&recorder, &game)) {
+            printf("Not enough memory for the recording.\n");
+            return 1;
+        }
+        console.recorder = &recorder;
+    }
+    
+    int ran = run_game(&timer, &console, &game);
+    cleanup(&timer, &console, &game);
+    if (!ran) {
+        printf("Could not start the input and render threads.\n");
+    }
+    
+    if (console.recorder) {
+        if (!save_replay(console.recorder, record_path)) {
+            printf("Could not write replay '%s'.\n", record_path);
+        }
+        free_recording(console.recorder);
+    }
+    if (console.timing) {
+        if (dump_histograms(timing_path, instrument.phases, PHASE_COUNT)) {
+            printf("Timing histograms written to '%s'.\n", timing_path);
+        }
+        else {
+            printf("Could not write timing histograms to '%s'.\n", timing_path);
+        }
+    }
+    if (console.replay) {
+        free_replay(console.replay);
+    }
+    if (console.autopilot) {
+        free_autopilot(console.autopilot);
+    }
+    free_game(&game);
+    free_board(&board);
     return 0;
 }
 
-void setup_console() {
-    console = GetStdHandle(STD_OUTPUT_HANDLE);
+int setup_console(Console *c, const Board *b) {
+    c->output = GetStdHandle(STD_OUTPUT_HANDLE);
+    c->input = GetStdHandle(STD_INPUT_HANDLE);
+    FlushConsoleInputBuffer(c->input);
+    
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    COORD largest = {b->width + 2, b->height + 4};
+    if (GetConsoleScreenBufferInfo(c->output, &info)) {
+        largest = info.dwMaximumWindowSize;
+    }
+    
+    ViewSink sink = {c, console_frame, console_text};
+    if (!create_view(&c->view, b, largest.X, largest.Y, sink)) {
+        return 0;
+    }
+    
+    View *v = &c->view;
+    c->back_buffer = calloc((size_t)v->screen_width * v->screen_height, sizeof(CHAR_INFO));
+    if (!c->back_buffer) {
+        return 0;
+    }
     
-    SMALL_RECT window = {0, 0, WIDTH + 1, HEIGHT + 3};
-    SetConsoleWindowInfo(console, TRUE, &window);
+    SMALL_RECT window = {0, 0, (SHORT)(v->screen_width - 1), (SHORT)(v->screen_height - 1)};
+    SetConsoleWindowInfo(c->output, TRUE, &window);
     
-    COORD buffer_size = {WIDTH + 2, HEIGHT + 4};
-    SetConsoleScreenBufferSize(console, buffer_size);
+    COORD buffer_size = {(SHORT)v->screen_width, (SHORT)v->screen_height};
+    SetConsoleScreenBufferSize(c->output, buffer_size);
     
-    hide_cursor();
+    hide_cursor(c);
+    
+    if (!create_game(&c->shown, b, NULL) || !create_frames(&c->frames, b)) {
+        return 0;
+    }
+    init_inputs(&c->inputs);
+    
+    c->input_ready = CreateEvent(NULL, FALSE, FALSE, NULL);
+    c->frame_ready = CreateEvent(NULL, FALSE, FALSE, NULL);
+    c->stop = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!c->input_ready || !c->frame_ready || !c->stop) {
+        return 0;
+    }
     
     SetConsoleTitle("Snake Game - Use Arrow Keys");
+    return 1;
 }
 
-void hide_cursor() {
-    GetConsoleCursorInfo(console, &cursor_info);
-    cursor_info.bVisible = FALSE;
-    SetConsoleCursorInfo(console, &cursor_info);
+void hide_cursor(Console *c) {
+    GetConsoleCursorInfo(c->output, &c->cursor_info);
+    c->cursor_info.bVisible = FALSE;
+    SetConsoleCursorInfo(c->output, &c->cursor_info);
 }
 
-void init_game() {
-    snake_length = 3;
-    current_dir = RIGHT;
-    next_dir = RIGHT;
-    score = 0;
-    paused = 0;
+void console_frame(void *context, const char *text, int length) {
+    Console *c = context;
+    COORD pos = {0, 0};
+    DWORD written;
     
-    snake[0].x = WIDTH / 2;
-    snake[0].y = HEIGHT / 2;
-    snake[1].x = WIDTH / 2 - 1;
-    snake[1].y = HEIGHT / 2;
-    snake[2].x = WIDTH / 2 - 2;
-    snake[2].y = HEIGHT / 2;
+    SetConsoleCursorPosition(c->output, pos);
+    WriteConsoleA(c->output, text, length, &written, NULL);
+}
+
+void console_text(void *context, int x, int y, const char *text, int length) {
+    Console *c = context;
+    COORD pos = {(SHORT)x, (SHORT)y};
+    DWORD written;
     
-    spawn_food();
+    WriteConsoleOutputCharacterA(c->output, text, length, pos, &written);
 }
 
-void spawn_food() {
-    int valid = 0;
+void draw_game(Console *c, GameState *g) {
+    if (c->render_mode != RENDER_BLIT) {
+        draw_view(&c->view, g, c->render_mode == RENDER_FULL);
+        return;
+    }
     
-    while (!valid) {
-        food.x = rand() % WIDTH;
-        food.y = rand() % HEIGHT;
-        
-        valid = 1;
-        for (int i = 0; i < snake_length; i++) {
-            if (snake[i].x == food.x && snake[i].y == food.y) {
-                valid = 0;
-                break;
-            }
-        }
+    if (follow_head(&c->view, g)) {
+        g->full_redraw = 1;
     }
+    draw_blit(c, g);
+    end_frame(&c->view, g);
+}
+
+WORD char_attr(char ch) {
+    switch (ch) {
+        case 'O':
+            return FOREGROUND_GREEN | FOREGROUND_INTENSITY;
+        case 'o':
+            return FOREGROUND_GREEN;
+        case '*':
+            return FOREGROUND_RED | FOREGROUND_INTENSITY;
+        default:
+            return TEXT_ATTR;
+    }
+}
+
+void put_cell(Console *c, int x, int y, char ch) {
+    CHAR_INFO *info = &c->back_buffer[y * c->view.screen_width + x];
+    
+    info->Char.AsciiChar = ch;
+    info->Attributes = char_attr(ch);
 }
 
-void draw_game() {
-    int buf_idx = 0;
+void draw_blit(Console *c, GameState *g) {
+    View *v = &c->view;
     
-    for (int x = 0; x <= WIDTH + 1; x++) {
-        screen_buffer[buf_idx++] = '#';
+    if (!g->full_redraw && g->dirty_count == 0 && !status_changed(v, g)) {
+        return;
     }
-    screen_buffer[buf_idx++] = '\n';
     
-    for (int y = 0; y < HEIGHT; y++) {
-        screen_buffer[buf_idx++] = '#';
-        
-        for (int x = 0; x < WIDTH; x++) {
-            int is_snake = 0;
-            
-            if (snake[0].x == x && snake[0].y == y) {
-                screen_buffer[buf_idx++] = 'O';
-                is_snake = 1;
+    if (g->full_redraw) {
+        for (int y = 0; y < v->screen_height; y++) {
+            for (int x = 0; x < v->screen_width; x++) {
+                int border = y <= v->view_height + 1 && (x == 0 || x == v->view_width + 1 || y == 0 || y == v->view_height + 1);
+                put_cell(c, x, y, border ? '#' : ' ');
             }
-            else {
-                for (int i = 1; i < snake_length; i++) {
-                    if (snake[i].x == x && snake[i].y == y) {
-                        screen_buffer[buf_idx++] = 'o';
-                        is_snake = 1;
-                        break;
-                    }
-                }
-            }
-            
-            if (!is_snake && food.x == x && food.y == y) {
-                screen_buffer[buf_idx++] = '*';
+        }
+        
+        for (int y = 0; y < v->view_height; y++) {
+            for (int x = 0; x < v->view_width; x++) {
+                put_cell(c, x + 1, y + 1, cell_char(g, view_cell(v, g->board, x, y)));
             }
-            else if (!is_snake) {
-                screen_buffer[buf_idx++] = ' ';
+        }
+    }
+    else {
+        for (int i = 0; i < g->dirty_count; i++) {
+            Cell cell = g->dirty_cells[i];
+            int x;
+            int y;
+            if (view_position(v, g->board, cell, &x, &y)) {
+                put_cell(c, x, y, cell_char(g, cell));
             }
         }
+    }
+    
+    if (g->full_redraw || status_changed(v, g)) {
+        char *status = v->status_line;
+        int status_len = format_status(v, g, status);
         
-        screen_buffer[buf_idx++] = '#';
-        screen_buffer[buf_idx++] = '\n';
+        for (int i = 0; i < v->status_width; i++) {
+            CHAR_INFO *info = &c->back_buffer[(v->view_height + 2) * v->screen_width + i];
+            info->Char.AsciiChar = i < status_len ? status[i] : ' ';
+            info->Attributes = TEXT_ATTR;
+        }
     }
     
-    for (int x = 0; x <= WIDTH + 1; x++) {
-        screen_buffer[buf_idx++] = '#';
+    COORD size = {(SHORT)v->screen_width, (SHORT)v->screen_height};
+    COORD origin = {0, 0};
+    SMALL_RECT region = {0, 0, (SHORT)(v->screen_width - 1), (SHORT)(v->screen_height - 1)};
+    WriteConsoleOutputA(c->output, c->back_buffer, size, origin, &region);
+}
+
+void read_keys(Console *c) {
+    DWORD pending = 0;
+    
+    while (GetNumberOfConsoleInputEvents(c->input, &pending) && pending > 0) {
+        INPUT_RECORD events[INPUT_BATCH];
+        DWORD count = 0;
+        
+        if (!ReadConsoleInput(c->input, events, INPUT_BATCH, &count)) {
+            return;
+        }
+        
+        for (DWORD i = 0; i < count; i++) {
+            if (events[i].EventType == KEY_EVENT && events[i].Event.KeyEvent.bKeyDown) {
+                post_key(c, events[i].Event.KeyEvent.wVirtualKeyCode);
+            }
+        }
     }
-    screen_buffer[buf_idx++] = '\n';
+}
+
+void post_key(Console *c, WORD key) {
+    int command;
     
-    char status[100];
-    int status_len = sprintf(status, "Score: %d | Length: %d | ESC=Quit SPACE=Pause", score, snake_length);
-    for (int i = 0; i < status_len; i++) {
-        screen_buffer[buf_idx++] = status[i];
+    if ((c->autopilot || c->replay) && key >= VK_LEFT && key <= VK_DOWN) {
+        return;
     }
     
-    if (paused) {
-        char pause_msg[] = " [PAUSED]";
-        for (int i = 0; pause_msg[i] != '\0'; i++) {
-            screen_buffer[buf_idx++] = pause_msg[i];
-        }
+    switch (key) {
+        case VK_UP:
+            command = INPUT_UP;
+            break;
+        case VK_DOWN:
+            command = INPUT_DOWN;
+            break;
+        case VK_LEFT:
+            command = INPUT_LEFT;
+            break;
+        case VK_RIGHT:
+            command = INPUT_RIGHT;
+            break;
+        case VK_ESCAPE:
+            command = INPUT_QUIT;
+            break;
+        case VK_SPACE:
+            command = INPUT_PAUSE;
+            break;
+        default:
+            return;
     }
     
-    screen_buffer[buf_idx] = '\0';
+    if (push_input(&c->inputs, command, qpc_now())) {
+        SetEvent(c->input_ready);
+    }
+}
+
+DWORD WINAPI input_main(LPVOID context) {
+    Console *c = context;
+    HANDLE handles[2] = {c->stop, c->input};
     
-    COORD pos = {0, 0};
-    SetConsoleCursorPosition(console, pos);
-    DWORD written;
-    WriteConsoleA(console, screen_buffer, buf_idx, &written, NULL);
+    while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0 + 1) {
+        read_keys(c);
+    }
+    
+    return 0;
 }
 
-void process_input() {
-    if (_kbhit() && !dir_changed) {
-        int key = _getch();
-        
-        if (key == 0 || key == 224) {
-            if (_kbhit()) {
-                key = _getch();
-                
-                switch (key) {
-                    case 72:
-                        if (current_dir != DOWN) {
-                            next_dir = UP;
-                            dir_changed = 1;
-                        }
-                        break;
-                    case 80:
-                        if (current_dir != UP) {
-                            next_dir = DOWN;
-                            dir_changed = 1;
-                        }
-                        break;
-                    case 75:
-                        if (current_dir != RIGHT) {
-                            next_dir = LEFT;
-                            dir_changed = 1;
-                        }
-                        break;
-                    case 77:
-                        if (current_dir != LEFT) {
-                            next_dir = RIGHT;
-                            dir_changed = 1;
-                        }
-                        break;
-                }
-            }
-        }
-        else {
-            switch (key) {
-                case 27:
-                    game_running = 0;
-                    break;
-                case 32:
-                    paused = !paused;
-                    break;
-            }
-        }
-        
-        while (_kbhit()) _getch();
+DWORD WINAPI render_main(LPVOID context) {
+    Console *c = context;
+    int done = 0;
+    
+    while (!done) {
+        WaitForSingleObject(c->frame_ready, INFINITE);
+        done = atomic_load(&c->quit);
+        render_frame(c);
     }
+    
+    return 0;
 }
 
-int check_collision() {
-    for (int i = 1; i < snake_length; i++) {
-        if (snake[0].x == snake[i].x && snake[0].y == snake[i].y) {
+void render_frame(Console *c) {
+    const Frame *f = acquire_frame(&c->frames, &c->shown);
+    if (!f) return;
+    
+    LONGLONG start = qpc_now();
+    draw_game(c, &c->shown);
+    if (c->timing) {
+        time_frame(c, f, start, qpc_now());
+    }
+}
+
+int handle_input(Console *c, GameState *g, const InputEvent *e) {
+    switch (e->command) {
+        case INPUT_QUIT:
+            atomic_store(&c->quit, 1);
+            return 0;
+        case INPUT_PAUSE:
+            g->paused = !g->paused;
             return 1;
-        }
+        default:
+            queue_key(c, g, e);
+            return 0;
     }
+}
+
+void queue_key(Console *c, GameState *g, const InputEvent *e) {
+    int count = g->turn_count;
     
-    return 0;
+    queue_turn(g, (Direction)e->command);
+    if (c->timing && g->turn_count > count) {
+        c->timing->key_time[(g->turn_head + g->turn_count - 1) % TURN_QUEUE_SIZE] = e->time;
+    }
 }
 
-void move_snake() {
-    if (paused) return;
+int process_input(Console *c, GameState *g) {
+    InputEvent e;
+    int changed = 0;
     
-    current_dir = next_dir;
-    dir_changed = 0;
+    while (pop_input(&c->inputs, &e)) {
+        if (c->timing) {
+            record_sample(&c->timing->phases[PHASE_INPUT], qpc_ns(c->timing, qpc_now() - e.time));
+        }
+        changed |= handle_input(c, g, &e);
+    }
     
-    Position new_head = snake[0];
+    return changed;
+}
+
+void init_timer(Timer *t) {
+    QueryPerformanceFrequency(&t->frequency);
     
-    switch (current_dir) {
-        case UP:
-            new_head.y--;
-            break;
-        case DOWN:
-            new_head.y++;
-            break;
-        case LEFT:
-            new_head.x--;
+    t->timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (t->timer) {
+        t->spin_margin = t->frequency.QuadPart / 2000;
+    }
+    else {
+        t->period_set = timeBeginPeriod(1) == 0;
+        t->timer = CreateWaitableTimer(NULL, TRUE, NULL);
+        t->spin_margin = t->frequency.QuadPart / 500;
+    }
+}
+
+LONGLONG qpc_now() {
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    return now.QuadPart;
+}
+
+LONGLONG tick_period(Timer *t, GameState *g) {
+    return t->frequency.QuadPart * tick_period_ms(g) / 1000;
+}
+
+int wait_until(Timer *t, Console *c, GameState *g, LONGLONG deadline) {
+    HANDLE handles[2] = {t->timer, c->input_ready};
+    
+    while (!atomic_load(&c->quit) && g->status == GAME_RUNNING && t->timer) {
+        LONGLONG remaining = deadline - qpc_now();
+        if (remaining <= t->spin_margin) {
             break;
-        case RIGHT:
-            new_head.x++;
+        }
+        
+        LARGE_INTEGER due;
+        due.QuadPart = -((remaining - t->spin_margin) * 10000000 / t->frequency.QuadPart);
+        SetWaitableTimer(t->timer, &due, 0, NULL, NULL, FALSE);
+        
+        if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0) {
             break;
+        }
+        if (process_input(c, g)) {
+            return 1;
+        }
     }
     
-    for (int i = snake_length - 1; i > 0; i--) {
-        snake[i] = snake[i - 1];
+    while (!atomic_load(&c->quit) && qpc_now() < deadline) {
+        YieldProcessor();
     }
     
-    snake[0] = new_head;
-    
-    if (snake[0].x < 0) snake[0].x = WIDTH - 1;
-    if (snake[0].x >= WIDTH) snake[0].x = 0;
-    if (snake[0].y < 0) snake[0].y = HEIGHT - 1;
-    if (snake[0].y >= HEIGHT) snake[0].y = 0;
-    
-    if (check_collision()) {
-        game_running = 0;
+    return 0;
+}
+
+int replay_done(Console *c) {
+    return c->replay && c->replay->tick >= c->replay->header.ticks;
+}
+
+void advance_game(Console *c, GameState *g) {
+    if (c->replay) {
+        if (!g->paused) {
+            replay_step(c->replay, g);
+        }
         return;
     }
     
-    if (snake[0].x == food.x && snake[0].y == food.y) {
-        if (snake_length < MAX_LENGTH) {
-            snake_length++;
-            score += 10;
-            
-            if (speed > 50) {
-                speed -= 2;
-            }
-        }
-        spawn_food();
+    step(g, c->autopilot ? autopilot_action(c->autopilot, g) : ACTION_NONE);
+    if (c->recorder && !record_tick(c->recorder, g)) {
+        free_recording(c->recorder);
+        c->recorder = NULL;
     }
 }
 
-void game_loop() {
-    while (game_running) {
-        process_input();
+void publish_state(Console *c, GameState *g, LONGLONG input_time) {
+    publish_frame(&c->frames, g, qpc_now(), input_time);
+    SetEvent(c->frame_ready);
+}
+
+void game_loop(Timer *t, Console *c, GameState *g) {
+    LONGLONG next_tick = qpc_now();
+    int changed = 1;
+    
+    while (!atomic_load(&c->quit) && g->status == GAME_RUNNING && !replay_done(c)) {
+        changed |= process_input(c, g);
         
-        move_snake();
-        draw_game();
+        if (g->paused) {
+            if (changed) {
+                publish_state(c, g, 0);
+                changed = 0;
+            }
+            WaitForSingleObject(c->input_ready, INFINITE);
+            next_tick = qpc_now();
+            continue;
+        }
         
-        int actual_speed = speed;
-        if (current_dir == UP || current_dir == DOWN) {
-            actual_speed = (int)(speed * 1.8);
+        LONGLONG now = qpc_now();
+        if (now - next_tick > MAX_CATCH_UP_TICKS * tick_period(t, g)) {
+            next_tick = now;
         }
         
-        Sleep(actual_speed);
+        int ticked = 0;
+        while (!atomic_load(&c->quit) && g->status == GAME_RUNNING && !replay_done(c) && now >= next_tick) {
+            int head = g->turn_head;
+            int count = g->turn_count;
+            advance_game(c, g);
+            if (c->timing) {
+                note_turn(c->timing, g, head, count);
+            }
+            next_tick += tick_period(t, g);
+            ticked = 1;
+        }
+        
+        if (ticked || changed) {
+            LONGLONG input_time = c->timing && ticked ? time_ticks(c->timing, now, qpc_now()) : 0;
+            publish_state(c, g, input_time);
+        }
+        
+        changed = wait_until(t, c, g, next_tick);
+    }
+}
+
+int run_game(Timer *t, Console *c, GameState *g) {
+    HANDLE render = CreateThread(NULL, 0, render_main, c, 0, NULL);
+    HANDLE input = render ? CreateThread(NULL, 0, input_main, c, 0, NULL) : NULL;
+    
+    if (input) {
+        game_loop(t, c, g);
+    }
+    
+    atomic_store(&c->quit, 1);
+    SetEvent(c->stop);
+    SetEvent(c->frame_ready);
+    if (input) {
+        WaitForSingleObject(input, INFINITE);
+        CloseHandle(input);
+    }
+    if (render) {
+        WaitForSingleObject(render, INFINITE);
+        CloseHandle(render);
+    }
+    
+    return input != NULL;
+}
+
+void init_instrument(Instrument *ins, LONGLONG frequency) {
+    static const char *names[PHASE_COUNT] = {"input", "move", "draw", "frame", "latency"};
+    
+    memset(ins, 0, sizeof(*ins));
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        ins->phases[i].name = names[i];
     }
+    ins->frequency = frequency;
 }
 
-void cleanup() {
-    COORD pos = {0, HEIGHT + 4};
-    SetConsoleCursorPosition(console, pos);
+uint64_t qpc_ns(Instrument *ins, LONGLONG delta) {
+    return delta > 0 ? (uint64_t)((double)delta * 1e9 / (double)ins->frequency) : 0;
+}
+
+void note_turn(Instrument *ins, GameState *g, int head, int count) {
+    if (count > 0 && g->turn_head != head && ins->turn_time == 0) {
+        ins->turn_time = ins->key_time[head];
+    }
+}
+
+LONGLONG time_ticks(Instrument *ins, LONGLONG start, LONGLONG done) {
+    LONGLONG turn_time = ins->turn_time;
+    
+    record_sample(&ins->phases[PHASE_MOVE], qpc_ns(ins, done - start));
+    ins->turn_time = 0;
+    return turn_time;
+}
+
+void time_frame(Console *c, const Frame *f, LONGLONG start, LONGLONG done) {
+    Instrument *ins = c->timing;
     
-    cursor_info.bVisible = TRUE;
-    SetConsoleCursorInfo(console, &cursor_info);
+    record_sample(&ins->phases[PHASE_DRAW], qpc_ns(ins, done - start));
+    record_sample(&ins->phases[PHASE_FRAME], qpc_ns(ins, done - f->published));
+    if (f->input_time != 0) {
+        record_sample(&ins->phases[PHASE_LATENCY], qpc_ns(ins, done - f->input_time));
+    }
     
-    printf("\nGame Over! Final Score: %d\n", score);
+    if (done >= ins->next_overlay) {
+        update_overlay(c);
+        ins->next_overlay = done + ins->frequency * OVERLAY_PERIOD_MS / 1000;
+    }
+}
+
+void update_overlay(Console *c) {
+    Histogram *frame = &c->timing->phases[PHASE_FRAME];
+    Histogram *latency = &c->timing->phases[PHASE_LATENCY];
+    
+    snprintf(c->view.overlay, OVERLAY_MAX, " | frame %.2f/%.2f/%.2f ms | lag %.1f/%.1f/%.1f ms",
+             histogram_percentile(frame, 0.50) / 1e6, histogram_percentile(frame, 0.99) / 1e6, frame->max / 1e6,
+             histogram_percentile(latency, 0.50) / 1e6, histogram_percentile(latency, 0.99) / 1e6, latency->max / 1e6);
+    c->view.status_dirty = 1;
+}
+
+void cleanup(Timer *t, Console *c, GameState *g) {
+    if (t->timer) {
+        CloseHandle(t->timer);
+    }
+    if (t->period_set) {
+        timeEndPeriod(1);
+    }
+    
+    COORD pos = {0, (SHORT)c->view.screen_height};
+    SetConsoleCursorPosition(c->output, pos);
+    
+    c->cursor_info.bVisible = TRUE;
+    SetConsoleCursorInfo(c->output, &c->cursor_info);
+    
+    if (g->status == GAME_WON) {
+        printf("\nYou Win! The board is full. Final Score: %d\n", g->score);
+    }
+    else {
+        printf("\nGame Over! Final Score: %d\n", g->score);
+    }
     printf("Press any key to exit...\n");
+    FlushConsoleInputBuffer(c->input);
     _getch();
-}
\ No newline at end of file
+    
+    free_view(&c->view);
+    free(c->back_buffer);
+    free_game(&c->shown);
+    free_frames(&c->frames);
+    if (c->input_ready) {
+        CloseHandle(c->input_ready);
+    }
+    if (c->frame_ready) {
+        CloseHandle(c->frame_ready);
+    }
+    if (c->stop) {
+        CloseHandle(c->stop);
+    }
+}